@@ -0,0 +1,55 @@
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Measures the compile of a KB to which a few hundred rules are added.
+ * A compiled KB of Phillip cannot be reopened for writing,
+ * so adding rules means compiling the whole KB again.
+ * The time is split into inserting axioms and finalize(),
+ * to show which part a real update path would have to avoid.
+ * `finalize_share` is only an upper bound on what such a path could save,
+ * not a measured saving, since no such path exists to be timed.
+ */
+BENCH(add_rules)
+{
+    const int NUM_DELTA = 300;
+
+    for (int n : opt.sizes)
+    {
+        kb_config_t conf(SHAPE_EVENT, n);
+        std::string imp = generator_t(conf, opt.seed).implications();
+        std::string inc = generator_t(conf, opt.seed).inconsistencies(n / 100);
+        std::string delta = generator_t(
+            kb_config_t(SHAPE_EVENT, NUM_DELTA), opt.seed + 1).implications();
+        std::string key = format("n=%d+%d", n, NUM_DELTA);
+
+        stopwatch_t sw;
+        setup_kb(opt.kb_path, "basic", "basic", 4.0f);
+        insert_implications(imp);
+        insert_inconsistencies(inc);
+        double t_base = sw.elapsed();
+
+        sw.restart();
+        insert_implications(delta, "add_");
+        double t_delta = sw.elapsed();
+
+        sw.restart();
+        kb::kb()->finalize();
+        double t_finalize = sw.elapsed();
+
+        double t_total = t_base + t_delta + t_finalize;
+
+        report("add_rules", key + "/insert_base", t_base, "sec");
+        report("add_rules", key + "/insert_delta", t_delta, "sec");
+        report("add_rules", key + "/finalize", t_finalize, "sec");
+        report("add_rules", key + "/finalize_share", t_finalize / t_total, "ratio");
+    }
+}
+
+
+}
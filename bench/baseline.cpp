@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "./bench.h"
+#include "./baseline.h"
+
+
+namespace phbench
+{
+
+
+namespace
+{
+
+/** A minimal JSON value, which is enough to read baseline files. */
+struct json_t
+{
+    enum { NIL, NUMBER, STRING, ARRAY, OBJECT } type;
+    double number;
+    std::string string;
+    std::vector<json_t> array;
+    std::map<std::string, json_t> object;
+
+    json_t() : type(NIL), number(0.0) {}
+};
+
+
+class json_reader_t
+{
+public:
+    json_reader_t(const std::string &str) : m_str(str), m_pos(0) {}
+
+    bool read(json_t *out)
+    {
+        skip();
+        if (m_pos >= m_str.size()) return false;
+
+        char c = m_str[m_pos];
+
+        if (c == '{')
+        {
+            out->type = json_t::OBJECT;
+            for (++m_pos; skip(), m_pos < m_str.size();)
+            {
+                if (m_str[m_pos] == '}') { ++m_pos; return true; }
+                if (m_str[m_pos] == ',') { ++m_pos; continue; }
+
+                json_t key;
+                if (not read(&key) or key.type != json_t::STRING) return false;
+                skip();
+                if (m_pos >= m_str.size() or m_str[m_pos++] != ':') return false;
+                if (not read(&out->object[key.string])) return false;
+            }
+            return false;
+        }
+
+        if (c == '[')
+        {
+            out->type = json_t::ARRAY;
+            for (++m_pos; skip(), m_pos < m_str.size();)
+            {
+                if (m_str[m_pos] == ']') { ++m_pos; return true; }
+                if (m_str[m_pos] == ',') { ++m_pos; continue; }
+
+                out->array.push_back(json_t());
+                if (not read(&out->array.back())) return false;
+            }
+            return false;
+        }
+
+        if (c == '"')
+        {
+            out->type = json_t::STRING;
+            for (++m_pos; m_pos < m_str.size(); ++m_pos)
+            {
+                if (m_str[m_pos] == '"') { ++m_pos; return true; }
+                if (m_str[m_pos] == '\\' and m_pos + 1 < m_str.size()) ++m_pos;
+                out->string += m_str[m_pos];
+            }
+            return false;
+        }
+
+        if (c == 'n' and m_str.compare(m_pos, 4, "null") == 0)
+        {
+            m_pos += 4;
+            return true;
+        }
+
+        char *end;
+        out->type = json_t::NUMBER;
+        out->number = std::strtod(m_str.c_str() + m_pos, &end);
+        if (end == m_str.c_str() + m_pos) return false;
+        m_pos = end - m_str.c_str();
+
+        return true;
+    }
+
+private:
+    void skip()
+    {
+        while (m_pos < m_str.size() and std::isspace(m_str[m_pos])) ++m_pos;
+    }
+
+    const std::string &m_str;
+    size_t m_pos;
+};
+
+
+/** Returns whether `str` matches `pattern`, in which '*' matches any string. */
+bool match(const char *pattern, const char *str)
+{
+    if (*pattern == '\0') return *str == '\0';
+    if (*pattern == '*')
+        return match(pattern + 1, str) or (*str != '\0' and match(pattern, str + 1));
+    return (*pattern == *str) and match(pattern + 1, str + 1);
+}
+
+
+/** Returns whether larger values of the unit are better. */
+bool is_higher_better(const std::string &unit)
+{
+    return
+        (unit.size() > 4 and unit.compare(unit.size() - 4, 4, "/sec") == 0) or
+        (unit == "x");
+}
+
+}
+
+
+double get_median(std::vector<double> values)
+{
+    return get_percentile(&values, 50.0);
+}
+
+
+double get_mad(const std::vector<double> &values)
+{
+    double median = get_median(values);
+    std::vector<double> devs;
+
+    for (double v : values)
+        devs.push_back(std::fabs(v - median));
+
+    return get_median(devs);
+}
+
+
+bool baseline_t::load(const std::string &path)
+{
+    std::ifstream fin(path);
+    if (not fin) return false;
+
+    std::stringstream ss;
+    ss << fin.rdbuf();
+
+    std::string str = ss.str();
+    json_t root;
+    if (not json_reader_t(str).read(&root) or root.type != json_t::OBJECT)
+    {
+        std::fprintf(stderr, "Failed to parse \"%s\".\n", path.c_str());
+        return false;
+    }
+
+    m_tolerance = root.object["tolerance"].number;
+
+    m_gates.clear();
+    for (const auto &g : root.object["gates"].array)
+        m_gates.push_back(g.string);
+
+    m_metrics.clear();
+    for (auto &m : root.object["metrics"].object)
+    {
+        metric_t &metric = m_metrics[m.first];
+        metric.median = m.second.object["median"].number;
+        metric.mad = m.second.object["mad"].number;
+        metric.unit = m.second.object["unit"].string;
+    }
+
+    return true;
+}
+
+
+bool baseline_t::save(const std::string &path) const
+{
+    std::ofstream fout(path);
+    if (not fout) return false;
+
+    fout.precision(10);
+    fout << "{\n  \"tolerance\": " << m_tolerance << ",\n  \"gates\": [";
+    for (size_t i = 0; i < m_gates.size(); ++i)
+        fout << (i > 0 ? ",\n    \"" : "\n    \"") << m_gates[i] << "\"";
+    fout << "\n  ],\n  \"metrics\": {";
+
+    size_t i(0);
+    for (const auto &m : m_metrics)
+        fout << (i++ > 0 ? ",\n    \"" : "\n    \"") << m.first << "\": "
+             << "{\"median\": " << m.second.median
+             << ", \"mad\": " << m.second.mad
+             << ", \"unit\": \"" << m.second.unit << "\"}";
+    fout << "\n  }\n}\n";
+
+    return true;
+}
+
+
+void baseline_t::update(
+    const samples_t &samples, const std::map<std::string, std::string> &units)
+{
+    for (const auto &s : samples)
+    {
+        if (not is_gated(s.first)) continue;
+
+        metric_t &metric = m_metrics[s.first];
+        metric.median = get_median(s.second);
+        metric.mad = get_mad(s.second);
+        metric.unit = units.at(s.first);
+    }
+}
+
+
+int baseline_t::compare(const samples_t &samples, bool allow_missing) const
+{
+    int n_regression(0);
+
+    for (const auto &s : samples)
+    {
+        if (not is_gated(s.first)) continue;
+
+        auto found = m_metrics.find(s.first);
+        if (found == m_metrics.end())
+        {
+            // A gate without its baseline checks nothing, so it fails by default.
+            std::printf("[ NO BASE  ] %s\n", s.first.c_str());
+            if (not allow_missing) ++n_regression;
+            continue;
+        }
+
+        const metric_t &base = found->second;
+        double median = get_median(s.second);
+        double mad = get_mad(s.second);
+
+        // Change in the direction of getting worse.
+        double worse = is_higher_better(base.unit) ?
+            base.median - median : median - base.median;
+
+        // Allows the relative tolerance plus three sigmas of noise,
+        // where sigma is estimated from MAD as in normal distribution.
+        double limit =
+            m_tolerance * std::fabs(base.median) +
+            3.0 * 1.4826 * std::max(base.mad, mad);
+
+        bool is_regressed = (worse > limit);
+        if (is_regressed) ++n_regression;
+
+        std::printf(
+            "[%s] %s: %g -> %g %s (limit %g)\n",
+            is_regressed ? " REGRESSED" : "    OK    ",
+            s.first.c_str(), base.median, median, base.unit.c_str(), limit);
+    }
+
+    return n_regression;
+}
+
+
+bool baseline_t::is_gated(const std::string &name) const
+{
+    for (const auto &g : m_gates)
+        if (match(g.c_str(), name.c_str()))
+            return true;
+    return false;
+}
+
+
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace phbench
+{
+
+
+/** Samples of each metric, keyed by "bench/key". */
+typedef std::map<std::string, std::vector<double> > samples_t;
+
+
+/** Statistics of a metric in the baseline. */
+struct metric_t
+{
+    double median;
+    double mad; // Median absolute deviation.
+    std::string unit;
+};
+
+
+/**
+ * A store of baselines of benchmarks, which is saved as a JSON file.
+ * Only metrics which match one of the gate patterns are stored and compared.
+ */
+class baseline_t
+{
+public:
+    baseline_t() : m_tolerance(0.1) {}
+
+    bool load(const std::string &path);
+    bool save(const std::string &path) const;
+
+    /** Replaces the baselines of gated metrics with the statistics of samples. */
+    void update(
+        const samples_t &samples, const std::map<std::string, std::string> &units);
+
+    /**
+     * Compares samples with the baselines and prints the result of each metric.
+     * Returns the number of metrics which regressed, which includes gated metrics
+     * without baselines unless `allow_missing` is true.
+     */
+    int compare(const samples_t &samples, bool allow_missing = false) const;
+
+private:
+    bool is_gated(const std::string &name) const;
+
+    double m_tolerance; // Relative change allowed on top of noise.
+    std::vector<std::string> m_gates;
+    std::map<std::string, metric_t> m_metrics;
+};
+
+
+/** Returns the median of values. */
+double get_median(std::vector<double> values);
+
+/** Returns the median absolute deviation of values. */
+double get_mad(const std::vector<double> &values);
+
+
+}
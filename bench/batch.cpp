@@ -0,0 +1,87 @@
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Runs inference on a queue of generated documents with many threads,
+ * each of which has its own phillip_main_t and shares the same KB.
+ */
+BENCH(batch)
+{
+    const int NUM_DOCS = 200;
+    const int NUM_LITERALS = 30;
+    int max_thread = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::string> solvers = get_solver_keys();
+    std::string key_ilp = solvers.empty() ? "null" : "weighted";
+    std::string key_sol = solvers.empty() ? "null" : solvers.front();
+
+    for (int n : opt.sizes)
+    {
+        kb_config_t conf(SHAPE_EVENT, n);
+        std::vector<lf::input_t> docs;
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        insert_implications(generator_t(conf, opt.seed).implications());
+        insert_unification_postponements(
+            generator_t(conf, opt.seed).unification_postponements());
+        kb::kb()->finalize();
+        kb::kb()->prepare_query();
+
+        for (int i = 0; i < NUM_DOCS; ++i)
+            docs.push_back(generator_t(conf, opt.seed + i)
+                           .input(format("doc%d", i), NUM_LITERALS));
+
+        for (int n_thread = 1; n_thread <= max_thread; n_thread *= 2)
+        {
+            std::vector<std::unique_ptr<phillip_main_t> > phillips;
+            std::vector<double> latencies(docs.size());
+            std::vector<std::thread> threads;
+            std::atomic<size_t> next_doc(0);
+
+            // Components are set up before threads start,
+            // since setup_phillip calls prepare_query() of the shared KB.
+            for (int t = 0; t < n_thread; ++t)
+            {
+                phillips.emplace_back(new phillip_main_t());
+                phillips.back()->set_param("max_distance", "4.0");
+                setup_phillip(phillips.back().get(), "a*", key_ilp, key_sol);
+            }
+
+            stopwatch_t sw;
+            for (int t = 0; t < n_thread; ++t)
+            {
+                threads.push_back(std::thread([&, t]()
+                {
+                    for (size_t i = next_doc++; i < docs.size(); i = next_doc++)
+                    {
+                        stopwatch_t d;
+                        phillips[t]->infer(docs[i]);
+                        latencies[i] = d.elapsed();
+                    }
+                }));
+            }
+
+            for (auto &th : threads)
+                th.join();
+            double t = sw.elapsed();
+
+            std::string key = format("n=%d/threads=%d", n, n_thread);
+            report("batch", key + "/throughput", docs.size() / t, "docs/sec");
+            for (double p : { 50.0, 95.0, 99.0 })
+                report("batch", key + format("/p%g", p),
+                       get_percentile(&latencies, p), "sec");
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+
+#include "../src/test.h"
+
+
+namespace phbench
+{
+
+using namespace phil;
+using namespace phtest;
+
+
+/** Options of benchmarks, given from the command line. */
+struct option_t
+{
+    std::vector<int> sizes; // Numbers of axioms of generated KBs.
+    std::string kb_path;    // Path of the KB which benchmarks compile.
+    unsigned seed;          // Seed for generating KBs.
+    int repeat;             // Number of times to run each benchmark.
+};
+
+
+/** A value reported by a benchmark. */
+struct result_t
+{
+    std::string name; // "bench/key"
+    double value;
+    std::string unit;
+};
+
+
+/** A class to measure wall-clock time in seconds. */
+class stopwatch_t
+{
+public:
+    stopwatch_t() { restart(); }
+
+    void restart() { m_begin = std::chrono::steady_clock::now(); }
+
+    double elapsed() const
+    {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - m_begin).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+
+/** A singleton which holds every benchmark registered by BENCH. */
+class bench_library_t
+{
+public:
+    typedef std::function<void(const option_t&)> bench_t;
+
+    static bench_library_t* instance();
+
+    bool add(const std::string &name, bench_t func);
+    const std::vector<std::pair<std::string, bench_t> >& benches() const
+    { return m_benches; }
+
+    void add_result(const result_t &r) { m_results.push_back(r); }
+    const std::vector<result_t>& results() const { return m_results; }
+
+    void add_failure() { ++m_num_failure; }
+    int num_failure() const { return m_num_failure; }
+
+private:
+    bench_library_t() : m_num_failure(0) {}
+
+    std::vector<std::pair<std::string, bench_t> > m_benches;
+    std::vector<result_t> m_results;
+    int m_num_failure;
+};
+
+
+/**
+ * Prints a result of a benchmark in the form of "bench key value unit"
+ * and stores it to bench_library_t.
+ */
+void report(
+    const std::string &bench, const std::string &key,
+    double value, const std::string &unit);
+
+/**
+ * Prints a failure of a check in a benchmark to stderr.
+ * phil-bench exits with non-zero if any failure is reported,
+ * whether or not the results are compared with the baseline.
+ */
+void fail(
+    const std::string &bench, const std::string &key, const std::string &message);
+
+/** Returns paths of the files which compose the KB. */
+std::vector<std::string> get_kb_files(const std::string &kb_path);
+
+/** Returns the total size in bytes of the files which compose the KB. */
+size_t get_kb_file_size(const std::string &kb_path);
+
+/**
+ * Writes back pages of a file and drops them from the page cache.
+ * Returns false if not supported. The kernel may still keep some pages,
+ * so callers must check get_resident_bytes() to know the file is evicted.
+ */
+bool evict_page_cache(const std::string &path);
+
+/** Returns bytes of a file which are in the page cache. */
+size_t get_resident_bytes(const std::string &path);
+
+/** Returns the peak resident set size of this process in bytes. */
+size_t get_peak_rss();
+
+/**
+ * Runs `func` in a child process and returns the values it returned.
+ * Since the peak RSS of a process never decreases,
+ * runs whose memory usage is compared must be done in separate processes.
+ */
+std::vector<double> run_in_child(
+    const std::function<std::vector<double>()> &func);
+
+
+}
+
+
+/**
+ * Defines a benchmark and registers it to bench_library_t.
+ * `opt` is marked as unused, since some benchmarks take no options.
+ */
+#define BENCH(_name) \
+    static void bench_##_name(const phbench::option_t&); \
+    static bool _is_registered_##_name = \
+        phbench::bench_library_t::instance()->add(#_name, bench_##_name); \
+    static void bench_##_name(__attribute__((unused)) const phbench::option_t &opt)
@@ -0,0 +1,109 @@
+#include <atomic>
+#include <numeric>
+#include <thread>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Computes soft-unifying costs of all pairs in `arities` with n_thread threads.
+ * Rows of the matrix are distributed to threads dynamically.
+ */
+static void compute_cost_matrix(
+    const std::vector<std::string> &arities, int n_thread, std::vector<float> *out)
+{
+    size_t n = arities.size();
+    std::atomic<size_t> next_row(0);
+    std::vector<std::thread> threads;
+
+    out->assign(n * n, 0.0f);
+
+    for (int t = 0; t < n_thread; ++t)
+    {
+        threads.push_back(std::thread([&]()
+        {
+            for (size_t i = next_row++; i < n; i = next_row++)
+                for (size_t j = 0; j < n; ++j)
+                    (*out)[i * n + j] =
+                        kb::kb()->get_soft_unifying_cost(arities[i], arities[j]);
+        }));
+    }
+
+    for (auto &th : threads)
+        th.join();
+}
+
+
+/**
+ * Benchmarks the cost matrix of soft-unification over the category table.
+ * Any cost computed with threads which differs from the serial one is a failure.
+ */
+BENCH(category)
+{
+    const int MAX_PREDICATES = 2000;
+    int max_thread = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_TAXONOMY, n), opt.seed);
+        std::vector<std::string> arities;
+
+        setup_kb(opt.kb_path, "basic", "basic", 4.0f);
+        insert_implications(gen.implications());
+        kb::kb()->finalize();
+        kb::kb()->prepare_query();
+
+        for (int i = 0; i <= n and arities.size() < MAX_PREDICATES; ++i)
+        {
+            std::string arity = format("t%d/1", i);
+            if (kb::kb()->do_target_on_category_table(arity))
+                arities.push_back(arity);
+        }
+
+        std::string key = format("n=%d", n);
+        std::vector<float> serial;
+        double pairs = static_cast<double>(arities.size()) * arities.size();
+        double t_serial(0.0);
+
+        report("category", key + "/predicates", arities.size(), "predicates");
+
+        for (int n_thread = 1; n_thread <= max_thread; n_thread *= 2)
+        {
+            std::vector<float> matrix;
+            stopwatch_t sw;
+
+            compute_cost_matrix(arities, n_thread, &matrix);
+            double t = sw.elapsed();
+
+            if (n_thread == 1)
+            {
+                serial.swap(matrix);
+                t_serial = t;
+            }
+
+            std::string k = key + format("/threads=%d", n_thread);
+            report("category", k + "/throughput", pairs / t, "pairs/sec");
+            report("category", k + "/speedup", t_serial / t, "x");
+
+            if (n_thread > 1)
+            {
+                int n_mismatch = std::inner_product(
+                    matrix.begin(), matrix.end(), serial.begin(), 0,
+                    std::plus<int>(), std::not_equal_to<float>());
+
+                report("category", k + "/mismatch", n_mismatch, "pairs");
+                if (n_mismatch > 0)
+                    fail("category", k + "/mismatch",
+                         format("%d costs differ from 1 thread", n_mismatch));
+            }
+        }
+    }
+}
+
+
+}
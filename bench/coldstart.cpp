@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <unistd.h>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Measures the time from loading a compiled KB to the first answers,
+ * with the KB files in the page cache (warm) and out of it (cold).
+ * Each load is done in a fresh child process.
+ */
+BENCH(coldstart)
+{
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_TAXONOMY, n), opt.seed);
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        insert_implications(gen.implications());
+        kb::kb()->finalize();
+
+        std::vector<std::string> files = get_kb_files(opt.kb_path);
+        std::string leaf = format("t%d/1", n);
+
+        for (bool is_cold : { true, false })
+        {
+            std::string key = format("n=%d/%s", n, is_cold ? "cold" : "warm");
+            size_t resident_before(0);
+
+            if (is_cold)
+                for (const auto &f : files)
+                    evict_page_cache(f);
+
+            for (const auto &f : files)
+                resident_before += get_resident_bytes(f);
+
+            // A cold run is measured only if the KB is actually out of the page cache,
+            // allowing a page per file, since the return code cannot tell it.
+            if (is_cold and resident_before > files.size() * sysconf(_SC_PAGESIZE))
+            {
+                std::fprintf(
+                    stderr, "Failed to evict the KB from the page cache"
+                    " (%zu bytes resident). Skips the cold run.\n", resident_before);
+                report("coldstart", key + "/resident_before",
+                       resident_before / 1048576.0, "MB");
+                continue;
+            }
+
+            std::vector<double> res = run_in_child([&]()
+            {
+                stopwatch_t sw;
+
+                kb::knowledge_base_t::setup(opt.kb_path, 4.0f, 1, false);
+                kb::kb()->set_distance_provider("basic");
+                kb::kb()->set_category_table("null");
+                kb::kb()->prepare_query();
+                double t_load = sw.elapsed();
+
+                kb::kb()->search_arity_id(leaf);
+                double t_arity = sw.elapsed();
+
+                kb::kb()->get_distance(leaf, "t0/1");
+                double t_dist = sw.elapsed();
+
+                size_t resident(0);
+                for (const auto &f : files)
+                    resident += get_resident_bytes(f);
+
+                return std::vector<double>{
+                    t_load, t_arity, t_dist, static_cast<double>(resident) };
+            });
+
+            if (res.size() != 4) continue;
+
+            report("coldstart", key + "/load", res[0], "sec");
+            report("coldstart", key + "/first_arity", res[1], "sec");
+            report("coldstart", key + "/first_distance", res[2], "sec");
+            if (is_cold)
+                report("coldstart", key + "/touched",
+                       (res[3] - resident_before) / 1048576.0, "MB");
+        }
+
+        report("coldstart", format("n=%d/disk", n),
+               get_kb_file_size(opt.kb_path) / 1048576.0, "MB");
+    }
+}
+
+
+}
@@ -0,0 +1,46 @@
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+BENCH(compile)
+{
+    for (int n : opt.sizes)
+    {
+        std::string str =
+            generator_t(kb_config_t(SHAPE_TAXONOMY, n), opt.seed).implications();
+        std::string key = format("n=%d", n);
+        stopwatch_t sw;
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        double t_setup = sw.elapsed();
+
+        sw.restart();
+        int n_imp = insert_implications(str);
+        double t_insert = sw.elapsed();
+
+        sw.restart();
+        kb::kb()->finalize();
+        double t_finalize = sw.elapsed();
+
+        sw.restart();
+        kb::kb()->prepare_query();
+        double t_query = sw.elapsed();
+
+        double t_total = t_setup + t_insert + t_finalize;
+
+        report("compile", key + "/setup", t_setup, "sec");
+        report("compile", key + "/insert", t_insert, "sec");
+        report("compile", key + "/finalize", t_finalize, "sec");
+        report("compile", key + "/prepare_query", t_query, "sec");
+        report("compile", key + "/throughput", n_imp / t_total, "axioms/sec");
+        report("compile", key + "/disk",
+               get_kb_file_size(opt.kb_path) / 1048576.0, "MB");
+    }
+}
+
+
+}
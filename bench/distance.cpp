@@ -0,0 +1,142 @@
+#include <random>
+
+#include "./bench.h"
+#include "../src/generator.h"
+#include "../src/distance.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Runs queries through the string API, distance_cache_t one by one,
+ * and distance_cache_t in a batch, and reports them.
+ * Any answer of the cache which differs from the string API is a failure.
+ */
+static void run_distance_queries(
+    const std::string &key,
+    const std::vector<std::string> &arities,
+    const std::vector<std::pair<int, int> > &queries)
+{
+    distance_cache_t cache, batch_cache;
+    std::vector<kb::arity_id_t> ids;
+    std::vector<distance_cache_t::arity_pair_t> pairs;
+    std::vector<float> by_str(queries.size()), by_id(queries.size()), by_batch;
+    std::vector<double> lat_str(queries.size()), lat_id(queries.size());
+
+    for (const auto &a : arities)
+    {
+        ids.push_back(cache.search(a));
+        batch_cache.search(a);
+    }
+    for (const auto &q : queries)
+        pairs.push_back(std::make_pair(ids[q.first], ids[q.second]));
+
+    stopwatch_t sw;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        stopwatch_t q;
+        by_str[i] = kb::kb()->get_distance(
+            arities[queries[i].first], arities[queries[i].second]);
+        lat_str[i] = q.elapsed();
+    }
+    double t_str = sw.elapsed();
+
+    sw.restart();
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        stopwatch_t q;
+        by_id[i] = cache.get(ids[queries[i].first], ids[queries[i].second]);
+        lat_id[i] = q.elapsed();
+    }
+    double t_id = sw.elapsed();
+
+    sw.restart();
+    batch_cache.get(pairs, &by_batch);
+    double t_batch = sw.elapsed();
+
+    int n_mismatch(0);
+    for (size_t i = 0; i < queries.size(); ++i)
+        if (by_str[i] != by_id[i] or by_str[i] != by_batch[i]) ++n_mismatch;
+
+    report("distance", key + "/string/qps", queries.size() / t_str, "queries/sec");
+    report("distance", key + "/cached/qps", queries.size() / t_id, "queries/sec");
+    report("distance", key + "/batched/qps", queries.size() / t_batch, "queries/sec");
+    report("distance", key + "/cached/hit_rate", cache.hit_rate() * 100.0, "%");
+    for (double p : { 50.0, 90.0, 99.0, 99.9 })
+    {
+        report("distance", key + format("/string/p%g", p),
+               get_percentile(&lat_str, p) * 1e6, "usec");
+        report("distance", key + format("/cached/p%g", p),
+               get_percentile(&lat_id, p) * 1e6, "usec");
+    }
+    report("distance", key + "/mismatch", n_mismatch, "queries");
+
+    if (n_mismatch > 0)
+        fail("distance", key + "/mismatch",
+             format("%d answers differ from the string API", n_mismatch));
+}
+
+
+/** Benchmarks all-pairs and random-pairs distance queries. */
+BENCH(distance)
+{
+    const int MAX_ALL_PAIRS = 1000;
+    const int NUM_RANDOM = 1000000;
+    const int NUM_HOT = 1000;
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_TAXONOMY, n), opt.seed);
+        std::mt19937 rand(opt.seed);
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        insert_implications(gen.implications());
+        kb::kb()->finalize();
+        kb::kb()->prepare_query();
+
+        std::vector<std::string> arities;
+        for (int i = 0; i <= std::min(n, 100000); ++i)
+            arities.push_back(format("t%d/1", i));
+
+        // ALL PAIRS AMONG THE UPPER PART OF THE TAXONOMY
+        {
+            int m = std::min<int>(arities.size(), MAX_ALL_PAIRS);
+            std::vector<std::pair<int, int> > queries;
+
+            for (int i = 0; i < m; ++i)
+                for (int j = 0; j < m; ++j)
+                    queries.push_back(std::make_pair(i, j));
+
+            run_distance_queries(format("n=%d/all", n), arities, queries);
+        }
+
+        // RANDOM PAIRS, MOST OF WHICH ARE FROM A SMALL SET OF HOT PAIRS
+        {
+            std::vector<std::pair<int, int> > hot, queries;
+            auto random_pair = [&]()
+            {
+                int i = rand() % arities.size();
+                int j = rand() % arities.size();
+                return std::make_pair(i, j);
+            };
+
+            for (int i = 0; i < NUM_HOT; ++i)
+                hot.push_back(random_pair());
+
+            for (int i = 0; i < NUM_RANDOM; ++i)
+            {
+                if (rand() % 10 < 8)
+                    queries.push_back(hot[rand() % hot.size()]);
+                else
+                    queries.push_back(random_pair());
+            }
+
+            run_distance_queries(format("n=%d/random", n), arities, queries);
+        }
+    }
+}
+
+
+}
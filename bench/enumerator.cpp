@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <map>
+#include <set>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/** Returns the string of a literal in which every unknown is written as "_u". */
+static std::string get_signature(const literal_t &lit)
+{
+    std::string str = lit.to_string(), out;
+
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        out += str[i];
+        if (str.compare(i, 2, "_u") == 0)
+        {
+            out += 'u';
+            for (i += 2; i < str.size() and std::isdigit(str[i]); ++i);
+            --i;
+        }
+    }
+
+    return out;
+}
+
+
+/** Returns the signature of a node, which is its literal and depth. */
+static std::string get_signature(const pg::proof_graph_t *graph, pg::node_idx_t idx)
+{
+    const pg::node_t &node = graph->node(idx);
+    return format("%s:%d", get_signature(node.literal()).c_str(), node.depth());
+}
+
+
+/** Returns sorted signatures of nodes in a hypernode, or "-" for no hypernode. */
+static std::string get_signature_of_hypernode(
+    const pg::proof_graph_t *graph, pg::hypernode_idx_t idx)
+{
+    if (idx < 0) return "-";
+
+    std::vector<std::string> sigs;
+    for (auto n : graph->hypernode(idx))
+        sigs.push_back(get_signature(graph, n));
+    std::sort(sigs.begin(), sigs.end());
+
+    std::string out;
+    for (const auto &s : sigs)
+        out += (out.empty() ? "" : ",") + s;
+    return out;
+}
+
+
+/**
+ * Runs an enumerator and returns signatures of its nodes and edges.
+ * A signature of an edge is its type, axiom-id and signatures of its tail and head.
+ */
+static std::multiset<std::string> enumerate(
+    const std::string &key, const std::string &max_dist, const lf::input_t &input)
+{
+    phillip_main_t phillip;
+    std::multiset<std::string> out;
+
+    string_hash_t::reset_unknown_hash_count();
+    phillip.set_param("max_distance", max_dist);
+    setup_phillip(&phillip, key, "null", "null");
+    phillip.infer(input);
+
+    const pg::proof_graph_t *graph = phillip.get_latent_hypotheses_set();
+
+    for (size_t i = 0; i < graph->nodes().size(); ++i)
+        out.insert("N " + get_signature(graph, i));
+
+    for (const auto &edge : graph->edges())
+        out.insert(format(
+            "E %d %ld %s => %s",
+            static_cast<int>(edge.type()), static_cast<long>(edge.axiom_id()),
+            get_signature_of_hypernode(graph, edge.tail()).c_str(),
+            get_signature_of_hypernode(graph, edge.head()).c_str()));
+
+    return out;
+}
+
+
+/**
+ * Runs the depth-based and the A*-based enumerators on generated KBs
+ * over max_distance and compares their cost and output.
+ * Every node and edge of A* must be yielded by the depth-based one too,
+ * and any which is not makes phil-bench fail.
+ */
+BENCH(enumerator)
+{
+    const std::vector<std::string> KEYS = { "depth", "a*" };
+    const int NUM_LITERALS = 30;
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_EVENT, n), opt.seed);
+        lf::input_t input = gen.input("Enumerator", NUM_LITERALS);
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        insert_implications(gen.implications());
+        insert_unification_postponements(gen.unification_postponements());
+        kb::kb()->finalize();
+
+        for (int d = 1; d <= 4; ++d)
+        {
+            std::string max_dist = format("%d.0", d);
+            std::string key = format("n=%d/d=%d", n, d);
+            std::map<std::string, std::vector<double> > results;
+
+            for (const auto &k : KEYS)
+            {
+                results[k] = run_in_child([&]()
+                {
+                    phillip_main_t phillip;
+                    size_t rss_base = get_peak_rss();
+
+                    phillip.set_param("max_distance", max_dist);
+                    setup_phillip(&phillip, k, "null", "null");
+
+                    stopwatch_t sw;
+                    phillip.infer(input);
+                    double t = sw.elapsed();
+
+                    const pg::proof_graph_t *graph =
+                        phillip.get_latent_hypotheses_set();
+                    return std::vector<double>{
+                        t, static_cast<double>(get_peak_rss() - rss_base),
+                        static_cast<double>(graph->nodes().size()),
+                        static_cast<double>(graph->edges().size()) };
+                });
+
+                if (results[k].size() != 4) continue;
+
+                report("enumerator", key + "/" + k + "/time", results[k][0], "sec");
+                report("enumerator", key + "/" + k + "/peak_rss",
+                       results[k][1] / 1048576.0, "MB");
+                report("enumerator", key + "/" + k + "/nodes", results[k][2], "nodes");
+                report("enumerator", key + "/" + k + "/edges", results[k][3], "edges");
+            }
+
+            if (results["depth"].size() == 4 and results["a*"].size() == 4)
+            {
+                report("enumerator", key + "/pruning/nodes",
+                       1.0 - results["a*"][2] / results["depth"][2], "ratio");
+                report("enumerator", key + "/pruning/edges",
+                       1.0 - results["a*"][3] / results["depth"][3], "ratio");
+            }
+
+            // COUNTS NODES AND EDGES OF A* WHICH THE DEPTH-BASED ENUMERATOR DOES NOT YIELD
+            std::multiset<std::string> s_depth = enumerate("depth", max_dist, input);
+            std::multiset<std::string> s_astar = enumerate("a*", max_dist, input);
+            std::vector<std::string> diff;
+
+            std::set_difference(
+                s_astar.begin(), s_astar.end(), s_depth.begin(), s_depth.end(),
+                std::back_inserter(diff));
+            report("enumerator", key + "/not_subset", diff.size(), "elements");
+
+            for (const auto &d : diff)
+                fail("enumerator", key + "/not_subset", d);
+        }
+    }
+}
+
+
+}
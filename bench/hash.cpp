@@ -0,0 +1,132 @@
+#include <thread>
+
+#include "./bench.h"
+
+
+namespace phbench
+{
+
+
+/** Runs func(i) on n_thread threads and returns the elapsed time. */
+static double run_threads(int n_thread, const std::function<void(int)> &func)
+{
+    std::vector<std::thread> threads;
+    stopwatch_t sw;
+
+    for (int t = 0; t < n_thread; ++t)
+        threads.push_back(std::thread(func, t));
+    for (auto &th : threads)
+        th.join();
+
+    return sw.elapsed();
+}
+
+
+/** Keeps the compiler from optimizing away a value. */
+template <class T> static void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "r"(&value) : "memory");
+}
+
+
+/**
+ * Microbenchmarks of interning strings and constructing literals,
+ * run on 1, 2, 4, ... threads at once to see contention.
+ */
+BENCH(hash)
+{
+    const int NUM_OPS = 1000000;
+    const int NUM_MISS = 100000;
+    const int NUM_POOL = 1000;
+    int max_thread = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::string> pool;
+    for (int i = 0; i < NUM_POOL; ++i)
+    {
+        pool.push_back(format("word%d", i));
+        string_hash_t interned(pool.back());
+    }
+
+    std::vector<literal_t> lits;
+    for (int i = 0; i < NUM_POOL; ++i)
+        lits.push_back(literal_t(pool[i], { pool[(i + 1) % NUM_POOL], "x" }));
+
+    double base[5] = { 0.0 };
+
+    for (int n_thread = 1; n_thread <= max_thread; n_thread *= 2)
+    {
+        std::string key = format("threads=%d", n_thread);
+        std::vector<std::vector<std::string> > fresh(n_thread);
+        double t[5];
+
+        for (int th = 0; th < n_thread; ++th)
+            for (int i = 0; i < NUM_MISS; ++i)
+                fresh[th].push_back(format("new%d_%d_%d", n_thread, th, i));
+
+        t[0] = run_threads(n_thread, [&](int)
+        {
+            for (int i = 0; i < NUM_OPS; ++i)
+            {
+                string_hash_t h(pool[i % NUM_POOL]);
+                do_not_optimize(h);
+            }
+        });
+
+        t[1] = run_threads(n_thread, [&](int th)
+        {
+            for (const auto &str : fresh[th])
+            {
+                string_hash_t h(str);
+                do_not_optimize(h);
+            }
+        });
+
+        t[2] = run_threads(n_thread, [&](int)
+        {
+            for (int i = 0; i < NUM_OPS; ++i)
+            {
+                string_hash_t h(string_hash_t::get_unknown_hash());
+                do_not_optimize(h);
+            }
+        });
+
+        t[3] = run_threads(n_thread, [&](int)
+        {
+            for (int i = 0; i < NUM_OPS; ++i)
+            {
+                literal_t lit(
+                    pool[i % NUM_POOL], { pool[(i + 1) % NUM_POOL], "x" });
+                do_not_optimize(lit);
+            }
+        });
+
+        t[4] = run_threads(n_thread, [&](int)
+        {
+            int n_eq(0);
+            for (int i = 0; i < NUM_OPS; ++i)
+            {
+                const literal_t &l1 = lits[i % NUM_POOL];
+                const literal_t &l2 = lits[(i * 7) % NUM_POOL];
+                if (l1 == l2 or l1 < l2) ++n_eq;
+            }
+            do_not_optimize(n_eq);
+        });
+
+        const char *NAMES[5] = {
+            "string_hash/hit", "string_hash/miss", "string_hash/unknown",
+            "literal/construct", "literal/compare" };
+        const int OPS[5] = { NUM_OPS, NUM_MISS, NUM_OPS, NUM_OPS, NUM_OPS };
+
+        for (int i = 0; i < 5; ++i)
+        {
+            double ops = static_cast<double>(OPS[i]) * n_thread / t[i];
+            if (n_thread == 1) base[i] = ops;
+
+            report("hash", key + "/" + NAMES[i], ops, "ops/sec");
+            report("hash", key + "/" + NAMES[i] + "/scaling", ops / base[i], "x");
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,90 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Compares peak memory and throughput of inserting axioms
+ * through the string-based helpers and through insert_axioms_from_stream.
+ */
+BENCH(load)
+{
+    for (int n : opt.sizes)
+    {
+        std::string key = format("n=%d", n);
+        std::string src[3] = {
+            opt.kb_path + ".imp.lisp",
+            opt.kb_path + ".inc.lisp",
+            opt.kb_path + ".uni.lisp" };
+        size_t rss_base = get_peak_rss();
+
+        {
+            generator_t gen(kb_config_t(SHAPE_EVENT, n), opt.seed);
+            std::ofstream(src[0]) << gen.implications();
+            std::ofstream(src[1]) << gen.inconsistencies(n / 100);
+            std::ofstream(src[2]) << gen.unification_postponements();
+        }
+
+        std::vector<double> by_string = run_in_child([&]()
+        {
+            stopwatch_t sw;
+            std::string str[3];
+
+            // Reads each file straight into a string, so that no other copy is held.
+            for (int i = 0; i < 3; ++i)
+            {
+                std::ifstream fin(src[i]);
+                str[i].assign(
+                    std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+            }
+
+            setup_kb(opt.kb_path, "basic", "null", 4.0f);
+            int n_axiom =
+                insert_implications(str[0]) +
+                insert_inconsistencies(str[1]) +
+                insert_unification_postponements(str[2]);
+
+            return std::vector<double>{
+                n_axiom / sw.elapsed(), static_cast<double>(get_peak_rss()) };
+        });
+
+        std::vector<double> by_stream = run_in_child([&]()
+        {
+            stopwatch_t sw;
+            int n_axiom(0);
+
+            setup_kb(opt.kb_path, "basic", "null", 4.0f);
+            for (int i = 0; i < 3; ++i)
+            {
+                std::ifstream fin(src[i]);
+                n_axiom += insert_axioms_from_stream(fin);
+            }
+
+            return std::vector<double>{
+                n_axiom / sw.elapsed(), static_cast<double>(get_peak_rss()) };
+        });
+
+        if (by_string.size() == 2 and by_stream.size() == 2)
+        {
+            report("load", key + "/string/throughput", by_string[0], "axioms/sec");
+            report("load", key + "/string/peak_rss",
+                   (by_string[1] - rss_base) / 1048576.0, "MB");
+            report("load", key + "/stream/throughput", by_stream[0], "axioms/sec");
+            report("load", key + "/stream/peak_rss",
+                   (by_stream[1] - rss_base) / 1048576.0, "MB");
+        }
+
+        for (int i = 0; i < 3; ++i)
+            std::remove(src[i].c_str());
+    }
+}
+
+
+}
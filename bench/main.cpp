@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "./bench.h"
+#include "./baseline.h"
+
+
+namespace phbench
+{
+
+
+bench_library_t* bench_library_t::instance()
+{
+    static bench_library_t lib;
+    return &lib;
+}
+
+
+bool bench_library_t::add(const std::string &name, bench_t func)
+{
+    m_benches.push_back(std::make_pair(name, func));
+    return true;
+}
+
+
+void report(
+    const std::string &bench, const std::string &key,
+    double value, const std::string &unit)
+{
+    std::printf("%-16s %-32s %16.4f %s\n",
+                bench.c_str(), key.c_str(), value, unit.c_str());
+    std::fflush(stdout);
+
+    result_t r = { bench + "/" + key, value, unit };
+    bench_library_t::instance()->add_result(r);
+}
+
+
+void fail(
+    const std::string &bench, const std::string &key, const std::string &message)
+{
+    std::fprintf(stderr, "[  FAILED  ] %s/%s: %s\n",
+                 bench.c_str(), key.c_str(), message.c_str());
+    bench_library_t::instance()->add_failure();
+}
+
+
+std::vector<std::string> get_kb_files(const std::string &kb_path)
+{
+    std::string::size_type pos = kb_path.rfind('/');
+    std::string dir =
+        (pos == std::string::npos) ? "." : kb_path.substr(0, pos);
+    std::string prefix =
+        (pos == std::string::npos) ? kb_path : kb_path.substr(pos + 1);
+    std::vector<std::string> out;
+
+    DIR *dp = opendir(dir.c_str());
+    if (dp == NULL) return out;
+
+    for (struct dirent *ent = readdir(dp); ent != NULL; ent = readdir(dp))
+    {
+        std::string name(ent->d_name);
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+
+        struct stat st;
+        std::string path = dir + "/" + name;
+        if (stat(path.c_str(), &st) == 0 and S_ISREG(st.st_mode))
+            out.push_back(path);
+    }
+    closedir(dp);
+
+    return out;
+}
+
+
+size_t get_kb_file_size(const std::string &kb_path)
+{
+    size_t size(0);
+
+    for (const auto &path : get_kb_files(kb_path))
+    {
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0)
+            size += st.st_size;
+    }
+
+    return size;
+}
+
+
+bool evict_page_cache(const std::string &path)
+{
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    // DIRTY PAGES ARE NOT DROPPED, SO THEY ARE WRITTEN BACK FIRST.
+    int ret = fdatasync(fd);
+    if (ret == 0)
+        ret = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+
+    return (ret == 0);
+#else
+    return false;
+#endif
+}
+
+
+size_t get_resident_bytes(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return 0;
+
+    struct stat st;
+    size_t out(0);
+
+    if (fstat(fd, &st) == 0 and st.st_size > 0)
+    {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t n_page = (st.st_size + page - 1) / page;
+        void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+        if (addr != MAP_FAILED)
+        {
+            std::vector<unsigned char> vec(n_page);
+#ifdef __APPLE__
+            char *pvec = reinterpret_cast<char*>(&vec[0]);
+#else
+            unsigned char *pvec = &vec[0];
+#endif
+            if (mincore(addr, st.st_size, pvec) == 0)
+                for (unsigned char v : vec)
+                    if (v & 1) out += page;
+            munmap(addr, st.st_size);
+        }
+    }
+    close(fd);
+
+    return out;
+}
+
+
+size_t get_peak_rss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+    return usage.ru_maxrss;
+#else
+    return usage.ru_maxrss * 1024;
+#endif
+}
+
+
+std::vector<double> run_in_child(
+    const std::function<std::vector<double>()> &func)
+{
+    int fd[2];
+    std::vector<double> out;
+
+    if (pipe(fd) != 0) return out;
+    std::fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fd[0]);
+        std::vector<double> values = func();
+        size_t n = values.size();
+
+        if (write(fd[1], &n, sizeof(n)) < 0 or
+            write(fd[1], values.data(), n * sizeof(double)) < 0)
+            _exit(1);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    if (pid > 0)
+    {
+        size_t n(0);
+        if (read(fd[0], &n, sizeof(n)) == sizeof(n))
+        {
+            out.resize(n);
+            for (size_t i = 0; i < n * sizeof(double);)
+            {
+                ssize_t r = read(fd[0], reinterpret_cast<char*>(out.data()) + i,
+                                 n * sizeof(double) - i);
+                if (r <= 0) { out.clear(); break; }
+                i += r;
+            }
+        }
+        waitpid(pid, NULL, 0);
+    }
+    close(fd[0]);
+
+    return out;
+}
+
+
+}
+
+
+void print_usage()
+{
+    std::printf(
+        "Usage: phil-bench [options] [bench ...]\n"
+        "  -n SIZES : Comma-separated numbers of axioms."
+        " (default: 1000,10000,100000,1000000)\n"
+        "  -k PATH  : Path of the KB to compile. (default: compiled/bench)\n"
+        "  -s SEED  : Seed for generating KBs. (default: 0)\n"
+        "  -r NUM   : Number of times to run each benchmark."
+        " (default: 1, or 5 with -c or -w)\n"
+        "  -b PATH  : Path of the baseline. (default: bench/baseline.json)\n"
+        "  -c       : Compare results with the baseline"
+        " and fail on regressions.\n"
+        "             A gated metric without its baseline is a failure,"
+        " and the shipped\n"
+        "             baseline has none until -w is run on the reference machine.\n"
+        "  -a       : With -c, allow gated metrics without baselines.\n"
+        "  -w       : Write medians of results to the baseline.\n"
+        "  -l       : Print the list of benchmarks.\n");
+}
+
+
+int main(int argc, char **argv)
+{
+    using namespace phbench;
+
+    const int MIN_REPEAT_FOR_BASELINE = 5;
+
+    option_t opt;
+    opt.sizes = { 1000, 10000, 100000, 1000000 };
+    opt.kb_path = "compiled/bench";
+    opt.seed = 0;
+    opt.repeat = 0;
+
+    std::string baseline_path = "bench/baseline.json";
+    bool do_compare(false), do_write(false), allow_missing(false);
+
+    int c;
+    while ((c = getopt(argc, argv, "n:k:s:r:b:cawlh")) != -1)
+    {
+        switch (c)
+        {
+        case 'n':
+        {
+            std::istringstream ss(optarg);
+            std::string tok;
+            opt.sizes.clear();
+            while (std::getline(ss, tok, ','))
+                opt.sizes.push_back(std::atoi(tok.c_str()));
+            break;
+        }
+        case 'k':
+            opt.kb_path = optarg;
+            break;
+        case 's':
+            opt.seed = static_cast<unsigned>(std::atoi(optarg));
+            break;
+        case 'r':
+            opt.repeat = std::atoi(optarg);
+            if (opt.repeat < 1)
+            {
+                std::fprintf(stderr, "Invalid number of runs: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'b':
+            baseline_path = optarg;
+            break;
+        case 'c':
+            do_compare = true;
+            break;
+        case 'a':
+            allow_missing = true;
+            break;
+        case 'w':
+            do_write = true;
+            break;
+        case 'l':
+            for (const auto &b : bench_library_t::instance()->benches())
+                std::printf("%s\n", b.first.c_str());
+            return 0;
+        default:
+            print_usage();
+            return (c == 'h') ? 0 : 1;
+        }
+    }
+
+    // The baseline needs several samples of each metric to estimate its noise.
+    if (opt.repeat == 0)
+        opt.repeat = (do_compare or do_write) ? MIN_REPEAT_FOR_BASELINE : 1;
+    else if (opt.repeat < MIN_REPEAT_FOR_BASELINE and (do_compare or do_write))
+    {
+        std::fprintf(stderr, "-c and -w need -r %d or more.\n", MIN_REPEAT_FOR_BASELINE);
+        return 1;
+    }
+
+    phillip_main_t::set_verbose(NOT_VERBOSE);
+
+    int num_run(0);
+    for (int r = 0; r < opt.repeat; ++r)
+    {
+        for (const auto &b : bench_library_t::instance()->benches())
+        {
+            bool do_run = (optind == argc);
+            for (int i = optind; i < argc; ++i)
+                if (b.first == argv[i]) do_run = true;
+
+            if (do_run)
+            {
+                b.second(opt);
+                ++num_run;
+            }
+        }
+    }
+
+    if (num_run == 0)
+    {
+        std::fprintf(stderr, "No benchmark matched.\n");
+        return 1;
+    }
+
+    if (bench_library_t::instance()->num_failure() > 0)
+    {
+        std::fprintf(stderr, "%d checks failed.\n",
+                     bench_library_t::instance()->num_failure());
+        return 1;
+    }
+
+    if (do_compare or do_write)
+    {
+        baseline_t baseline;
+        samples_t samples;
+        std::map<std::string, std::string> units;
+
+        if (not baseline.load(baseline_path))
+        {
+            std::fprintf(stderr, "Cannot read \"%s\".\n", baseline_path.c_str());
+            return 1;
+        }
+
+        for (const auto &res : bench_library_t::instance()->results())
+        {
+            samples[res.name].push_back(res.value);
+            units[res.name] = res.unit;
+        }
+
+        if (do_compare and baseline.compare(samples, allow_missing) > 0)
+            return 1;
+
+        if (do_write)
+        {
+            baseline.update(samples, units);
+            if (not baseline.save(baseline_path))
+            {
+                std::fprintf(stderr, "Cannot write \"%s\".\n", baseline_path.c_str());
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
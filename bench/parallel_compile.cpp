@@ -0,0 +1,62 @@
+#include "./bench.h"
+#include "../src/generator.h"
+#include "../src/fingerprint.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Compiles the same KB with 1, 2, 4, 8 and 16 threads,
+ * and reports the speedup of finalize() over the single-threaded compile.
+ * Answers to queries are compared with those of the single-threaded KB,
+ * and any difference is a failure.
+ */
+BENCH(parallel_compile)
+{
+    const std::vector<int> THREADS = { 1, 2, 4, 8, 16 };
+    const int NUM_ARITIES = 100;
+
+    for (int n : opt.sizes)
+    {
+        std::string str =
+            generator_t(kb_config_t(SHAPE_TAXONOMY, n), opt.seed).implications();
+        std::vector<std::string> arities;
+        unsigned long long expected(0);
+        double t_single(0.0);
+
+        for (int i = 0; i < NUM_ARITIES; ++i)
+            arities.push_back(format("t%d/1", i * n / (NUM_ARITIES - 1)));
+
+        for (int n_thread : THREADS)
+        {
+            std::string key = format("n=%d/threads=%d", n, n_thread);
+
+            setup_kb(opt.kb_path, "basic", "basic", 4.0f, n_thread);
+            insert_implications(str);
+
+            stopwatch_t sw;
+            kb::kb()->finalize();
+            double t = sw.elapsed();
+
+            kb::kb()->prepare_query();
+            unsigned long long fp = get_fingerprint(get_kb_query_text(arities));
+
+            if (n_thread == 1)
+            {
+                expected = fp;
+                t_single = t;
+            }
+
+            report("parallel_compile", key + "/finalize", t, "sec");
+            report("parallel_compile", key + "/speedup", t_single / t, "x");
+
+            if (fp != expected)
+                fail("parallel_compile", key, "answers differ from 1 thread");
+        }
+    }
+}
+
+
+}
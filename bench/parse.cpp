@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "./bench.h"
+#include "../src/alloc.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/** A corpus of s-expressions and the number of literals in it. */
+struct corpus_t
+{
+    std::string name;
+    std::string text;
+    size_t num_literals;
+};
+
+
+const int NUM_CORPUS_KINDS = 5;
+
+
+/** Returns a corpus of n expressions of the kind-th shape. */
+static corpus_t make_corpus(int kind, int n, unsigned seed)
+{
+    const int DEPTH = 16;
+    const int NUM_ARGS = 32;
+    corpus_t out;
+
+    switch (kind)
+    {
+    case 0: // AXIOMS OF EVENTS, EACH OF WHICH HAS 6 LITERALS
+        out.name = "axioms";
+        out.text = generator_t(kb_config_t(SHAPE_EVENT, n), seed).implications();
+        out.num_literals = 6 * n;
+        break;
+
+    case 1: // AN OBSERVATION OF 3n LITERALS
+        out.name = "observation";
+        out.text =
+            generator_t(kb_config_t(SHAPE_EVENT, 100), seed).observation(3 * n);
+        out.num_literals = 3 * n;
+        break;
+
+    case 2: // DEEPLY NESTED CONJUNCTIONS
+        out.name = "nested";
+        for (int i = 0; i < n; ++i)
+        {
+            std::string lhs = format("(p%d x)", i % 100);
+            for (int d = 1; d < DEPTH; ++d)
+                lhs = format("(^ %s (p%d x))", lhs.c_str(), (i + d) % 100);
+            out.text += format("(=> %s (q%d x))", lhs.c_str(), i % 100);
+        }
+        out.num_literals = (DEPTH + 1) * n;
+        break;
+
+    case 3: // LITERALS WITH LONG ARGUMENT LISTS
+    {
+        std::string args;
+        for (int a = 0; a < NUM_ARGS; ++a)
+            args += format(" x%d", a);
+
+        out.name = "long_args";
+        for (int i = 0; i < n; ++i)
+            out.text += format(
+                "(=> (p%d%s) (q%d%s))", i % 100, args.c_str(), i % 100, args.c_str());
+        out.num_literals = 2 * n;
+        break;
+    }
+
+    default: // AXIOMS WITH WEIGHTS
+        out.name = "weighted";
+        for (int i = 0; i < n; ++i)
+            out.text += format(
+                "(=> (p%d x) (q%d x) :%d.%d)", i % 1000, i % 997, 1 + i % 3, i % 10);
+        out.num_literals = 2 * n;
+        break;
+    }
+
+    return out;
+}
+
+
+/**
+ * Measures throughput and memory of lf::parse on corpora,
+ * both on a whole string and on a file read in chunks by parse_stream.
+ * Peak memory of the chunked mode does not grow with the size of the file
+ * unless a single expression is large, so it shows whether files larger
+ * than memory can be parsed.
+ */
+BENCH(parse)
+{
+    for (int n : opt.sizes)
+    {
+        for (int kind = 0; kind < NUM_CORPUS_KINDS; ++kind)
+        {
+            corpus_t corpus = make_corpus(kind, n, opt.seed);
+            std::string key = format("n=%d/%s", n, corpus.name.c_str());
+            double mb = corpus.text.size() / 1048576.0;
+
+            {
+                std::list<lf::logical_function_t> funcs;
+                alloc_scope_t scope;
+                stopwatch_t sw;
+
+                lf::parse(corpus.text, &funcs);
+
+                double t = sw.elapsed();
+                alloc_stat_t stat = scope.stat();
+
+                report("parse", key + "/whole/throughput", mb / t, "MB/sec");
+                if (is_alloc_counted())
+                {
+                    report("parse", key + "/whole/alloc_per_literal",
+                           static_cast<double>(stat.num_alloc) / corpus.num_literals,
+                           "allocs");
+                    report("parse", key + "/whole/peak",
+                           stat.peak_live / 1048576.0, "MB");
+                }
+            }
+
+            {
+                std::string path = opt.kb_path + ".parse.lisp";
+                std::ofstream(path) << corpus.text;
+
+                std::ifstream fin(path);
+                alloc_scope_t scope;
+                stopwatch_t sw;
+
+                parse_stream(fin, [](const lf::logical_function_t&) {});
+
+                double t = sw.elapsed();
+                alloc_stat_t stat = scope.stat();
+
+                report("parse", key + "/chunked/throughput", mb / t, "MB/sec");
+                if (is_alloc_counted())
+                {
+                    report("parse", key + "/chunked/alloc_per_literal",
+                           static_cast<double>(stat.num_alloc) / corpus.num_literals,
+                           "allocs");
+                    report("parse", key + "/chunked/peak",
+                           stat.peak_live / 1048576.0, "MB");
+                }
+
+                std::remove(path.c_str());
+            }
+        }
+    }
+}
+
+
+}
@@ -0,0 +1,43 @@
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/** Compares the per-test overhead of recompiling a KB and sharing it. */
+BENCH(shared_kb)
+{
+    const int n_tests = 10;
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_EVENT, n), opt.seed);
+        std::string imp = gen.implications();
+        std::string uni = gen.unification_postponements();
+        std::string key = format("n=%d", n);
+
+        stopwatch_t sw;
+        for (int i = 0; i < n_tests; ++i)
+        {
+            setup_kb(opt.kb_path, "basic", "null", 4.0f);
+            insert_implications(imp);
+            insert_unification_postponements(uni);
+            kb::kb()->finalize();
+            kb::kb()->prepare_query();
+        }
+        report("shared_kb", key + "/recompile", sw.elapsed() / n_tests, "sec/test");
+
+        sw.restart();
+        for (int i = 0; i < n_tests; ++i)
+        {
+            setup_shared_kb("basic", "null", 4.0f, imp, "", uni);
+            kb::kb()->prepare_query();
+        }
+        report("shared_kb", key + "/shared", sw.elapsed() / n_tests, "sec/test");
+    }
+}
+
+
+}
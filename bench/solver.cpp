@@ -0,0 +1,74 @@
+#include <cmath>
+
+#include "./bench.h"
+#include "../src/generator.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Solves the same ILP problems with every available solver
+ * and compares their solving time and optimal objectives.
+ */
+BENCH(solver)
+{
+    const std::vector<std::string> KEYS = get_solver_keys();
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_EVENT, n), opt.seed);
+
+        setup_kb(opt.kb_path, "basic", "null", 4.0f);
+        insert_implications(gen.implications());
+        insert_unification_postponements(gen.unification_postponements());
+        kb::kb()->finalize();
+
+        for (int n_lit : { 10, 30, 100 })
+        {
+            lf::input_t input = gen.input("Solver", n_lit);
+            std::string key = format("n=%d/obs=%d", n, n_lit);
+            std::vector<double> objectives;
+
+            for (const auto &k : KEYS)
+            {
+                phillip_main_t phillip;
+
+                string_hash_t::reset_unknown_hash_count();
+                phillip.set_param("max_distance", "4.0");
+                setup_phillip(&phillip, "a*", "weighted", k);
+                phillip.infer(input);
+
+                const ilp::ilp_problem_t *prob = phillip.get_ilp_problem();
+                const ilp::ilp_solution_t &sol = phillip.get_solutions().front();
+
+                if (k == KEYS.front())
+                {
+                    report("solver", key + "/convert",
+                           phillip.get_time_for_ilp(), "sec");
+                    report("solver", key + "/variables",
+                           prob->variables().size(), "variables");
+                    report("solver", key + "/constraints",
+                           prob->constraints().size(), "constraints");
+                }
+
+                report("solver", key + "/" + k + "/time",
+                       phillip.get_time_for_sol(), "sec");
+                report("solver", key + "/" + k + "/objective",
+                       sol.value_of_objective_function(), "");
+                report("solver", key + "/" + k + "/optimal",
+                       (sol.type() == ilp::SOLUTION_OPTIMAL) ? 1 : 0, "bool");
+
+                objectives.push_back(sol.value_of_objective_function());
+            }
+
+            for (size_t i = 1; i < objectives.size(); ++i)
+                report("solver", key + "/" + KEYS[i] + "/objective_diff",
+                       std::fabs(objectives[i] - objectives[0]), "");
+        }
+    }
+}
+
+
+}
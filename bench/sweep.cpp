@@ -0,0 +1,132 @@
+#include <cmath>
+#include <fstream>
+#include <map>
+
+#include "./bench.h"
+#include "../src/generator.h"
+#include "../src/profile.h"
+
+
+namespace phbench
+{
+
+
+/** Returns the slope of the least-squares line fitted to (xs, ys). */
+static double fit_slope(const std::vector<double> &xs, const std::vector<double> &ys)
+{
+    double n = xs.size(), sx(0), sy(0), sxx(0), sxy(0);
+
+    for (size_t i = 0; i < xs.size(); ++i)
+    {
+        sx += xs[i];
+        sy += ys[i];
+        sxx += xs[i] * xs[i];
+        sxy += xs[i] * ys[i];
+    }
+
+    double denom = n * sxx - sx * sx;
+    return (denom != 0.0) ? (n * sxy - sx * sy) / denom : 0.0;
+}
+
+
+/**
+ * Runs inference over a grid of max_distance and branching factors of KBs,
+ * and writes the sizes of hypothesis spaces to a CSV file.
+ * Growth of the number of nodes is fitted as exp(rate * max_distance)
+ * for each branching factor, and as branch^exponent for each max_distance.
+ * Sizes of KBs are fixed by the grid, so `-n` is not used.
+ */
+BENCH(sweep)
+{
+    const std::vector<int> DISTANCES = { 1, 2, 3, 4, 5 };
+    const std::vector<int> BRANCHES = { 1, 2, 4, 8 };
+    const std::vector<std::string> ENUMERATORS = { "depth", "a*" };
+    const int NUM_EVENTS = 100;
+    const int NUM_LITERALS = 30;
+
+    std::vector<std::string> solvers = get_solver_keys();
+    std::string key_ilp = solvers.empty() ? "null" : "weighted";
+    std::string key_sol = solvers.empty() ? "null" : solvers.front();
+
+    std::string path = opt.kb_path + ".sweep.csv";
+    std::ofstream csv(path);
+    csv << "enumerator,branch,max_distance,nodes,edges,variables,constraints,"
+        << "time_lhs,time_ilp,time_sol,time_all\n";
+
+    // nodes[enumerator][branch index][distance index]
+    std::map<std::string, std::vector<std::vector<double> > > nodes;
+
+    for (size_t b = 0; b < BRANCHES.size(); ++b)
+    {
+        kb_config_t conf(SHAPE_EVENT, NUM_EVENTS * BRANCHES[b]);
+        conf.num_events = NUM_EVENTS;
+        generator_t gen(conf, opt.seed);
+        lf::input_t input = gen.input("Sweep", NUM_LITERALS);
+
+        setup_kb(opt.kb_path, "basic", "null", DISTANCES.back());
+        insert_implications(gen.implications());
+        insert_unification_postponements(gen.unification_postponements());
+        kb::kb()->finalize();
+
+        for (const auto &e : ENUMERATORS)
+        {
+            nodes[e].push_back(std::vector<double>());
+
+            for (int d : DISTANCES)
+            {
+                phillip_main_t phillip;
+
+                string_hash_t::reset_unknown_hash_count();
+                phillip.set_param("max_distance", format("%d.0", d));
+                setup_phillip(&phillip, e, key_ilp, key_sol);
+
+                infer_profile_t p = profile_infer(&phillip, input);
+                nodes[e].back().push_back(p.num_nodes);
+
+                csv << format(
+                    "%s,%d,%d,%zu,%zu,%zu,%zu,%.6f,%.6f,%.6f,%.6f\n",
+                    e.c_str(), BRANCHES[b], d, p.num_nodes, p.num_edges,
+                    p.num_variables, p.num_constraints,
+                    p.wall_lhs, p.wall_ilp, p.wall_sol, p.wall_infer);
+
+                std::string key = format("%s/b=%d/d=%d", e.c_str(), BRANCHES[b], d);
+                report("sweep", key + "/nodes", p.num_nodes, "nodes");
+                report("sweep", key + "/time", p.wall_infer, "sec");
+            }
+        }
+    }
+
+    for (const auto &e : ENUMERATORS)
+    {
+        for (size_t b = 0; b < BRANCHES.size(); ++b)
+        {
+            std::vector<double> xs, ys;
+            for (size_t d = 0; d < DISTANCES.size(); ++d)
+            {
+                xs.push_back(DISTANCES[d]);
+                ys.push_back(std::log(std::max(1.0, nodes[e][b][d])));
+            }
+
+            report("sweep", format("%s/b=%d/growth_per_distance", e.c_str(), BRANCHES[b]),
+                   std::exp(fit_slope(xs, ys)), "x");
+        }
+
+        for (size_t d = 0; d < DISTANCES.size(); ++d)
+        {
+            std::vector<double> xs, ys;
+            for (size_t b = 0; b < BRANCHES.size(); ++b)
+            {
+                xs.push_back(std::log(BRANCHES[b]));
+                ys.push_back(std::log(std::max(1.0, nodes[e][b][d])));
+            }
+
+            report("sweep", format("%s/d=%d/exponent_of_branch", e.c_str(), DISTANCES[d]),
+                   fit_slope(xs, ys), "");
+        }
+    }
+
+    std::fprintf(stderr, "The table was written to %s.\n", path.c_str());
+}
+
+
+}
@@ -0,0 +1,90 @@
+#include <map>
+
+#include "./bench.h"
+#include "../src/generator.h"
+#include "../src/profile.h"
+
+
+namespace phbench
+{
+
+
+/**
+ * Runs the same event-heavy observations on KBs with and without
+ * the unification-postponements for argument predicates,
+ * and compares unification edges, ILP sizes and inference time.
+ */
+BENCH(unipp)
+{
+    const std::vector<int> NUM_LITERALS = { 30, 100, 300 };
+
+    std::vector<std::string> solvers = get_solver_keys();
+    std::string key_ilp = solvers.empty() ? "null" : "weighted";
+    std::string key_sol = solvers.empty() ? "null" : solvers.front();
+
+    for (int n : opt.sizes)
+    {
+        generator_t gen(kb_config_t(SHAPE_EVENT, n), opt.seed);
+
+        // results[n_lit][with_unipp] = { unify edges, variables, constraints, time }
+        std::map<int, std::map<bool, std::vector<double> > > results;
+
+        for (bool with_unipp : { false, true })
+        {
+            setup_kb(opt.kb_path, "basic", "null", 4.0f);
+            insert_implications(gen.implications());
+            if (with_unipp)
+                insert_unification_postponements(gen.unification_postponements());
+            kb::kb()->finalize();
+
+            for (int n_lit : NUM_LITERALS)
+            {
+                phillip_main_t phillip;
+
+                string_hash_t::reset_unknown_hash_count();
+                phillip.set_param("max_distance", "4.0");
+                setup_phillip(&phillip, "a*", key_ilp, key_sol);
+
+                infer_profile_t p = profile_infer(&phillip, gen.input("Unipp", n_lit));
+                const pg::proof_graph_t *graph = phillip.get_latent_hypotheses_set();
+                size_t n_unify(0);
+
+                for (const auto &e : graph->edges())
+                    if (e.is_unify_edge()) ++n_unify;
+
+                std::string key = format(
+                    "n=%d/obs=%d/%s", n, n_lit, with_unipp ? "unipp" : "none");
+                report("unipp", key + "/unify_edges", n_unify, "edges");
+                report("unipp", key + "/edges", p.num_edges, "edges");
+                report("unipp", key + "/variables", p.num_variables, "variables");
+                report("unipp", key + "/constraints", p.num_constraints, "constraints");
+                report("unipp", key + "/time", p.wall_infer, "sec");
+
+                results[n_lit][with_unipp] = {
+                    static_cast<double>(n_unify),
+                    static_cast<double>(p.num_variables),
+                    static_cast<double>(p.num_constraints),
+                    p.wall_infer };
+            }
+        }
+
+        for (int n_lit : NUM_LITERALS)
+        {
+            const std::vector<double> &none = results[n_lit][false];
+            const std::vector<double> &unipp = results[n_lit][true];
+            std::string key = format("n=%d/obs=%d/saved", n, n_lit);
+
+            if (none[0] > 0)
+                report("unipp", key + "/unify_edges", 1.0 - unipp[0] / none[0], "ratio");
+            if (none[1] > 0)
+                report("unipp", key + "/variables", 1.0 - unipp[1] / none[1], "ratio");
+            if (none[2] > 0)
+                report("unipp", key + "/constraints", 1.0 - unipp[2] / none[2], "ratio");
+            if (none[3] > 0)
+                report("unipp", key + "/time", 1.0 - unipp[3] / none[3], "ratio");
+        }
+    }
+}
+
+
+}
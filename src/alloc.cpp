@@ -0,0 +1,192 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "./alloc.h"
+
+
+/* Replaces global operator new and operator delete with ones which count
+ * allocations. Each block has a header which holds its size, so that
+ * operator delete can know how many bytes get freed.
+ * With PHTEST_NO_ALLOC_COUNT defined, nothing is replaced and every counter is 0,
+ * so that timings of multi-threaded benchmarks are not skewed by the counters. */
+
+#ifndef PHTEST_NO_ALLOC_COUNT
+
+namespace
+{
+
+// Keeps blocks aligned as malloc does.
+const size_t HEADER_SIZE = 16;
+
+std::atomic<size_t> g_num_alloc(0);
+std::atomic<size_t> g_bytes_alloc(0);
+std::atomic<size_t> g_bytes_live(0);
+std::atomic<size_t> g_peak_live(0);
+
+
+void* counted_malloc(size_t size)
+{
+    void *p = std::malloc(size + HEADER_SIZE);
+    if (p == NULL) return NULL;
+
+    *static_cast<size_t*>(p) = size;
+
+    ++g_num_alloc;
+    g_bytes_alloc += size;
+    size_t live = (g_bytes_live += size);
+    size_t peak = g_peak_live.load();
+    while (live > peak and not g_peak_live.compare_exchange_weak(peak, live));
+
+    return static_cast<char*>(p) + HEADER_SIZE;
+}
+
+
+void counted_free(void *ptr)
+{
+    if (ptr == NULL) return;
+
+    void *p = static_cast<char*>(ptr) - HEADER_SIZE;
+    g_bytes_live -= *static_cast<size_t*>(p);
+    std::free(p);
+}
+
+
+void* counted_new(size_t size)
+{
+    if (size == 0) size = 1;
+
+    for (;;)
+    {
+        void *p = counted_malloc(size);
+        if (p != NULL) return p;
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == NULL) throw std::bad_alloc();
+        handler();
+    }
+}
+
+}
+
+
+void* operator new(size_t size)
+{
+    return counted_new(size);
+}
+
+void* operator new[](size_t size)
+{
+    return counted_new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return counted_new(size); }
+    catch (...) { return NULL; }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return counted_new(size); }
+    catch (...) { return NULL; }
+}
+
+void operator delete(void *ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept
+{
+    counted_free(ptr);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void *ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+#endif
+
+
+namespace phtest
+{
+
+
+bool is_alloc_counted()
+{
+    return true;
+}
+
+
+alloc_stat_t get_alloc_stat()
+{
+    alloc_stat_t out;
+    out.num_alloc = g_num_alloc.load();
+    out.bytes_alloc = g_bytes_alloc.load();
+    out.peak_live = g_peak_live.load();
+    return out;
+}
+
+
+size_t get_live_bytes()
+{
+    return g_bytes_live.load();
+}
+
+
+void reset_peak_live_bytes()
+{
+    g_peak_live = g_bytes_live.load();
+}
+
+
+}
+
+#else
+
+namespace phtest
+{
+
+
+bool is_alloc_counted()
+{
+    return false;
+}
+
+
+alloc_stat_t get_alloc_stat()
+{
+    alloc_stat_t out = { 0, 0, 0 };
+    return out;
+}
+
+
+size_t get_live_bytes()
+{
+    return 0;
+}
+
+
+void reset_peak_live_bytes() {}
+
+
+}
+
+#endif
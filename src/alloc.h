@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace phtest
+{
+
+
+/**
+ * Counters of dynamic memory allocation.
+ * They are counted by operator new and operator delete replaced in alloc.cpp.
+ */
+struct alloc_stat_t
+{
+    size_t num_alloc;   // Number of allocations.
+    size_t bytes_alloc; // Total bytes allocated.
+    size_t peak_live;   // Peak of bytes allocated and not yet freed.
+};
+
+
+/** Returns whether allocations are counted in this binary. */
+bool is_alloc_counted();
+
+/** Returns the counters since the process started. */
+alloc_stat_t get_alloc_stat();
+
+/** Returns bytes allocated and not yet freed. */
+size_t get_live_bytes();
+
+/** Sets the peak of live bytes to the current live bytes. */
+void reset_peak_live_bytes();
+
+
+/**
+ * A class to count allocations while an instance is alive.
+ * Since it resets the global peak, instances must not be nested.
+ */
+class alloc_scope_t
+{
+public:
+    alloc_scope_t()
+        : m_begin(get_alloc_stat()), m_live(get_live_bytes())
+    {
+        reset_peak_live_bytes();
+    }
+
+    /** Returns counters in this scope, where peak_live excludes bytes live before. */
+    alloc_stat_t stat() const
+    {
+        alloc_stat_t now = get_alloc_stat();
+        alloc_stat_t out;
+
+        out.num_alloc = now.num_alloc - m_begin.num_alloc;
+        out.bytes_alloc = now.bytes_alloc - m_begin.bytes_alloc;
+        out.peak_live = (now.peak_live > m_live) ? now.peak_live - m_live : 0;
+
+        return out;
+    }
+
+private:
+    alloc_stat_t m_begin;
+    size_t m_live;
+};
+
+
+}
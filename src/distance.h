@@ -0,0 +1,122 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./test.h"
+
+
+namespace phtest
+{
+
+using namespace phil;
+
+
+/**
+ * A layer to query distances between predicates by their arity-ids,
+ * which are given by search() of the same instance.
+ * Results of recent queries are held in a direct-mapped cache,
+ * so that repeated queries on hot pairs do not reach the KB.
+ * The KB takes only arities as strings, so misses are resolved
+ * through the strings which search() has recorded for the ids.
+ * An instance is valid only while the current KB is kept.
+ */
+class distance_cache_t
+{
+public:
+    typedef std::pair<kb::arity_id_t, kb::arity_id_t> arity_pair_t;
+
+    /** @param cache_size Number of entries of the cache, rounded to a power of 2. */
+    distance_cache_t(size_t cache_size = (1 << 16))
+        : m_num_hit(0), m_num_miss(0)
+    {
+        size_t size(1);
+        while (size < cache_size) size <<= 1;
+        m_cache.assign(size, entry_t());
+    }
+
+    /**
+     * Returns the arity-id of given arity, as search_arity_id() does,
+     * and records the arity to resolve misses of the id.
+     */
+    kb::arity_id_t search(const std::string &arity)
+    {
+        kb::arity_id_t id = kb::kb()->search_arity_id(arity);
+        if (id != kb::INVALID_AXIOM_ID)
+            m_arities[id] = arity;
+        return id;
+    }
+
+    /**
+     * Returns the distance between two arities, as get_distance() does.
+     * Returns -1 if either id has not been given by search().
+     */
+    float get(kb::arity_id_t a1, kb::arity_id_t a2)
+    {
+        unsigned long long key =
+            (static_cast<unsigned long long>(a1) << 32) ^
+            static_cast<unsigned long long>(a2);
+        entry_t &e = m_cache[hash(key) & (m_cache.size() - 1)];
+
+        if (e.is_valid and e.key == key)
+        {
+            ++m_num_hit;
+            return e.distance;
+        }
+
+        ++m_num_miss;
+
+        auto found1 = m_arities.find(a1);
+        auto found2 = m_arities.find(a2);
+        if (found1 == m_arities.end() or found2 == m_arities.end())
+            return -1.0f;
+
+        e.is_valid = true;
+        e.key = key;
+        e.distance = kb::kb()->get_distance(found1->second, found2->second);
+        return e.distance;
+    }
+
+    /** Returns distances of every pair in `pairs` in the same order. */
+    void get(const std::vector<arity_pair_t> &pairs, std::vector<float> *out)
+    {
+        out->resize(pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i)
+            (*out)[i] = get(pairs[i].first, pairs[i].second);
+    }
+
+    size_t num_hit() const { return m_num_hit; }
+    size_t num_miss() const { return m_num_miss; }
+
+    double hit_rate() const
+    {
+        size_t n = m_num_hit + m_num_miss;
+        return (n > 0) ? static_cast<double>(m_num_hit) / n : 0.0;
+    }
+
+private:
+    struct entry_t
+    {
+        entry_t() : is_valid(false), key(0), distance(0.0f) {}
+
+        bool is_valid;
+        unsigned long long key;
+        float distance;
+    };
+
+    static unsigned long long hash(unsigned long long x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::vector<entry_t> m_cache;
+    std::unordered_map<kb::arity_id_t, std::string> m_arities;
+    size_t m_num_hit, m_num_miss;
+};
+
+
+}
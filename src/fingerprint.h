@@ -0,0 +1,254 @@
+#pragma once
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/stat.h>
+
+#include "./test.h"
+
+
+namespace phtest
+{
+
+using namespace phil;
+
+
+/**
+ * A class to write proof-graphs and ILP solutions as canonical texts.
+ * Unknowns are renamed in order of their first appearance,
+ * so texts do not depend on how unknowns were numbered.
+ * Every method takes linear time in the size of its input.
+ */
+class canonical_writer_t
+{
+public:
+    /** Returns the canonical text of a proof-graph, one line per node or edge. */
+    std::string write(const pg::proof_graph_t *graph)
+    {
+        // Nodes are written first, so that unknowns are named in their order.
+        std::string out = write_nodes(graph);
+        return out + write_edges(graph);
+    }
+
+    /** Returns the canonical text of nodes of a proof-graph, one line per node. */
+    std::string write_nodes(const pg::proof_graph_t *graph)
+    {
+        std::string out;
+
+        for (size_t i = 0; i < graph->nodes().size(); ++i)
+        {
+            const pg::node_t &node = graph->node(i);
+            out += format("N%d %s %d\n", static_cast<int>(i),
+                          write(node.literal()).c_str(), node.depth());
+        }
+
+        return out;
+    }
+
+    /** Returns the canonical text of edges of a proof-graph, one line per edge. */
+    std::string write_edges(const pg::proof_graph_t *graph)
+    {
+        std::string out;
+
+        for (size_t i = 0; i < graph->edges().size(); ++i)
+        {
+            const pg::edge_t &edge = graph->edge(i);
+            out += format(
+                "E%d %d %ld %s => %s\n",
+                static_cast<int>(i), static_cast<int>(edge.type()),
+                static_cast<long>(edge.axiom_id()),
+                write_hypernode(graph, edge.tail()).c_str(),
+                write_hypernode(graph, edge.head()).c_str());
+        }
+
+        return out;
+    }
+
+    /** Returns the canonical text of nodes and edges active in a solution. */
+    std::string write(
+        const ilp::ilp_problem_t *prob, const ilp::ilp_solution_t &sol)
+    {
+        const pg::proof_graph_t *graph = prob->proof_graph();
+        std::string out;
+
+        for (size_t i = 0; i < graph->nodes().size(); ++i)
+        {
+            ilp::variable_idx_t v = prob->find_variable_with_node(i);
+            if (v >= 0 and sol.variable_is_active(v))
+                out += format("N%d %s\n", static_cast<int>(i),
+                              write(graph->node(i).literal()).c_str());
+        }
+
+        for (size_t i = 0; i < graph->edges().size(); ++i)
+        {
+            ilp::variable_idx_t v = prob->find_variable_with_edge(i);
+            if (v >= 0 and sol.variable_is_active(v))
+                out += format("E%d\n", static_cast<int>(i));
+        }
+
+        return out;
+    }
+
+    /** Returns the canonical text of a literal, such as "!p(x,_1)". */
+    std::string write(const literal_t &lit)
+    {
+        std::string out = lit.truth ? "" : "!";
+        out += lit.predicate.string() + "(";
+
+        for (size_t i = 0; i < lit.terms.size(); ++i)
+        {
+            if (i > 0) out += ",";
+            out += write(lit.terms[i]);
+        }
+
+        return out + ")";
+    }
+
+private:
+    std::string write(const term_t &term)
+    {
+        if (not term.is_unknown())
+            return term.string();
+
+        auto found = m_unknowns.find(term.string());
+        if (found != m_unknowns.end())
+            return found->second;
+
+        std::string name = format("_%d", static_cast<int>(m_unknowns.size() + 1));
+        m_unknowns[term.string()] = name;
+        return name;
+    }
+
+    std::string write_hypernode(
+        const pg::proof_graph_t *graph, pg::hypernode_idx_t idx)
+    {
+        if (idx < 0) return "-";
+
+        std::string out;
+        for (auto n : graph->hypernode(idx))
+            out += format("%s%d", out.empty() ? "" : ",", static_cast<int>(n));
+        return out;
+    }
+
+    std::unordered_map<std::string, std::string> m_unknowns;
+};
+
+
+/** Returns the canonical text of a proof-graph. */
+inline std::string get_canonical_text(const pg::proof_graph_t *graph)
+{
+    return canonical_writer_t().write(graph);
+}
+
+
+/**
+ * Returns a text of answers of the current KB to queries on given arities:
+ * search_arity_id and do_target_on_category_table for each arity,
+ * and get_distance and get_soft_unifying_cost for each pair of them.
+ * Floats are written with 9 significant digits, which identify each float,
+ * so KBs yield the same text only if they answer every query in the same way.
+ */
+inline std::string get_kb_query_text(const std::vector<std::string> &arities)
+{
+    std::string out;
+
+    for (const auto &a : arities)
+        out += format(
+            "A %s %ld %d\n", a.c_str(),
+            static_cast<long>(kb::kb()->search_arity_id(a)),
+            kb::kb()->do_target_on_category_table(a) ? 1 : 0);
+
+    for (const auto &a1 : arities)
+        for (const auto &a2 : arities)
+            out += format(
+                "D %s %s %.9g %.9g\n", a1.c_str(), a2.c_str(),
+                kb::kb()->get_distance(a1, a2),
+                kb::kb()->get_soft_unifying_cost(a1, a2));
+
+    return out;
+}
+
+
+/** Returns the 64-bit FNV-1a hash of a text. */
+inline unsigned long long get_fingerprint(const std::string &text)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+
+/** Returns the path of the golden file named `name` in PHTEST_GOLDEN_DIR (default: "golden"). */
+inline std::string get_golden_path(const std::string &name)
+{
+    const char *env = std::getenv("PHTEST_GOLDEN_DIR");
+    return std::string((env != NULL) ? env : "golden") + "/" + name + ".txt";
+}
+
+
+/** Returns whether golden files are to be rewritten, which is set by PHTEST_UPDATE_GOLDEN. */
+inline bool do_update_golden()
+{
+    return std::getenv("PHTEST_UPDATE_GOLDEN") != NULL;
+}
+
+
+/**
+ * Compares a text with the golden file named `name`.
+ * If PHTEST_UPDATE_GOLDEN is set, the text is written to the file
+ * and the assertion succeeds. Otherwise a missing file is a failure.
+ * On mismatch, the first different line is shown.
+ */
+inline ::testing::AssertionResult match_golden(
+    const std::string &name, const std::string &text)
+{
+    std::string path = get_golden_path(name);
+
+    if (do_update_golden())
+    {
+        mkdir(path.substr(0, path.rfind('/')).c_str(), 0755);
+        std::ofstream(path) << text;
+        return ::testing::AssertionSuccess() << "Wrote " << path;
+    }
+
+    std::ifstream fin(path);
+    if (not fin)
+        return ::testing::AssertionFailure()
+            << "Missing " << path << " (set PHTEST_UPDATE_GOLDEN to write it)";
+
+    std::stringstream ss;
+    ss << fin.rdbuf();
+    std::string golden = ss.str();
+
+    if (golden == text)
+        return ::testing::AssertionSuccess();
+
+    std::istringstream s1(golden), s2(text);
+    std::string l1, l2;
+    int line(1);
+
+    for (; std::getline(s1, l1), std::getline(s2, l2); ++line)
+        if (not s1 or not s2 or l1 != l2)
+            break;
+
+    return ::testing::AssertionFailure()
+        << "Mismatch with " << path
+        << format(" (fingerprint %016llx, expected %016llx)",
+                  get_fingerprint(text), get_fingerprint(golden))
+        << " at line " << line << ":\n"
+        << "  expected: " << (s1 ? l1 : "<EOF>") << "\n"
+        << "    actual: " << (s2 ? l2 : "<EOF>");
+}
+
+
+}
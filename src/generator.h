@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include "./test.h"
+
+
+namespace phtest
+{
+
+using namespace phil;
+
+
+/** Shapes of KBs which generator_t generates. */
+enum kb_shape_e
+{
+    SHAPE_CHAIN,    // Many chains of unary predicates: (=> (c0_1 x) (c0_0 x)).
+    SHAPE_TAXONOMY, // A wide tree of unary predicates.
+    SHAPE_EVENT     // Multi-literal rules among events and their arguments.
+};
+
+
+/** Parameters of a KB which generator_t generates. */
+struct kb_config_t
+{
+    kb_config_t(kb_shape_e s = SHAPE_TAXONOMY, int n = 1000)
+        : shape(s), num_axioms(n), depth(8), branch(8), num_events(100) {}
+
+    kb_shape_e shape;
+    int num_axioms;
+    int depth;      // Length of each chain for SHAPE_CHAIN.
+    int branch;     // Branching factor for SHAPE_TAXONOMY.
+    int num_events; // Number of event predicates for SHAPE_EVENT.
+};
+
+
+/**
+ * A generator of synthetic KBs and observations for scale testing.
+ * Outputs are s-expressions, which can be given to insert_implications,
+ * insert_inconsistencies, insert_unification_postponements and make_input.
+ * The same seed and the same config always yield the same output.
+ */
+class generator_t
+{
+public:
+    generator_t(const kb_config_t &conf, unsigned seed = 0)
+        : m_conf(conf), m_seed(seed) {}
+
+    /** Returns implications of conf.num_axioms axioms. */
+    std::string implications() const
+    {
+        std::mt19937 rand(m_seed);
+        std::string out;
+        out.reserve(m_conf.num_axioms * 48);
+
+        for (int i = 0; i < m_conf.num_axioms; ++i)
+        {
+            switch (m_conf.shape)
+            {
+            case SHAPE_CHAIN:
+            {
+                int c = i / m_conf.depth, d = i % m_conf.depth;
+                out += format(
+                    "(=> (c%d_%d x) (c%d_%d x))", c, d + 1, c, d);
+                break;
+            }
+            case SHAPE_TAXONOMY:
+                out += format(
+                    "(=> (t%d x) (t%d x))", i + 1, i / m_conf.branch);
+                break;
+            case SHAPE_EVENT:
+            {
+                int e1 = next(&rand, m_conf.num_events);
+                int e2 = next(&rand, m_conf.num_events);
+                bool swap = (next(&rand, 2) == 1);
+                out += format(
+                    "(=> (^ (ev%d *e1) (nsubj *e1 x) (dobj *e1 y))"
+                    " (^ (ev%d *e2) (nsubj *e2 %s) (dobj *e2 %s)))",
+                    e1, e2, swap ? "y" : "x", swap ? "x" : "y");
+                break;
+            }
+            }
+        }
+
+        return out;
+    }
+
+    /**
+     * Returns n axioms of xor between two different predicates appearing in the KB.
+     * Returns none if the KB has fewer than two predicates.
+     */
+    std::string inconsistencies(int n) const
+    {
+        std::mt19937 rand(m_seed + 1);
+        std::string out;
+
+        if (num_predicates() < 2) return out;
+
+        // PAIRS OF THE SAME PREDICATE ARE DRAWN AGAIN, SO THAT N AXIOMS ARE EMITTED
+        for (int i = 0; i < n;)
+        {
+            std::string p1 = predicate(&rand), p2 = predicate(&rand);
+            if (p1 == p2) continue;
+
+            out += format("(xor (%s x) (%s x))", p1.c_str(), p2.c_str());
+            ++i;
+        }
+
+        return out;
+    }
+
+    /** Returns unification-postponements for argument predicates. */
+    std::string unification_postponements() const
+    {
+        return
+            "(unipp (nsubj * .))"
+            "(unipp (dobj * .))"
+            "(unipp (iobj * .))";
+    }
+
+    /**
+     * Returns an observation of n literals as a conjunction.
+     * For SHAPE_EVENT, n is rounded up to a multiple of three.
+     */
+    std::string observation(int n) const
+    {
+        std::mt19937 rand(m_seed + 2);
+        std::string out("(^");
+
+        if (m_conf.shape == SHAPE_EVENT)
+        {
+            int n_ent = std::max(2, n / 4);
+
+            for (int i = 0; i * 3 < n; ++i)
+            {
+                int e = next(&rand, m_conf.num_events);
+                int x = next(&rand, n_ent);
+                int y = next(&rand, n_ent);
+                out += format(
+                    " (ev%d E%d) (nsubj E%d X%d) (dobj E%d X%d)",
+                    e, i, i, x, i, y);
+            }
+        }
+        else
+        {
+            for (int i = 0; i < n; ++i)
+                out += format(" (%s X%d)", predicate(&rand).c_str(), i);
+        }
+
+        return out + ")";
+    }
+
+    /** Returns an input whose observation has n literals. */
+    lf::input_t input(const std::string &name, int n) const
+    {
+        return make_input(name, observation(n));
+    }
+
+    const kb_config_t& config() const { return m_conf; }
+
+private:
+    /** Returns an integer in [0, n), which is same on every platform. */
+    static int next(std::mt19937 *rand, int n)
+    {
+        return static_cast<int>((*rand)() % static_cast<unsigned>(n));
+    }
+
+    /** Returns the number of predicates which predicate() chooses from. */
+    int num_predicates() const
+    {
+        switch (m_conf.shape)
+        {
+        case SHAPE_CHAIN:
+            return std::max(1, m_conf.num_axioms / m_conf.depth);
+        case SHAPE_TAXONOMY:
+            return m_conf.num_axioms + 1;
+        default:
+            return m_conf.num_events;
+        }
+    }
+
+    /** Returns a unary predicate chosen at random from the KB. */
+    std::string predicate(std::mt19937 *rand) const
+    {
+        int i = next(rand, num_predicates());
+
+        switch (m_conf.shape)
+        {
+        case SHAPE_CHAIN:
+            return format("c%d_0", i);
+        case SHAPE_TAXONOMY:
+            return format("t%d", i);
+        default:
+            return format("ev%d", i);
+        }
+    }
+
+    kb_config_t m_conf;
+    unsigned m_seed;
+};
+
+
+}
@@ -1,9 +1,359 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 #include <phillip.h>
 
+#include "./test.h"
+#include "./profile.h"
+
+
+/** Returns the value of an attribute in a start tag, or "" if it is not given. */
+std::string get_xml_attribute(const std::string &tag, const std::string &attr)
+{
+    std::string::size_type pos = tag.find(" " + attr + "=\"");
+    if (pos == std::string::npos) return "";
+
+    pos += attr.size() + 3;
+    return tag.substr(pos, tag.find('"', pos) - pos);
+}
+
+
+/** Testcases of a test case of Google Test gathered from the reports of workers. */
+struct suite_report_t
+{
+    std::string name;
+    int n_tests, n_failures;
+    std::string body; // <testcase> elements.
+};
+
+
+/**
+ * Adds the testcases which ran in a report of Google Test to `suites`.
+ * Every worker reports all tests matching the filter, and the ones of other shards
+ * have status="notrun", so only the ones with status="run" are taken.
+ * Returns false if the report has no root element.
+ */
+bool merge_xml_report(const std::string &xml, std::vector<suite_report_t> *suites)
+{
+    std::string::size_type pos = xml.find("<testsuites ");
+    if (pos == std::string::npos or xml.find("</testsuites>") == std::string::npos)
+        return false;
+
+    while ((pos = xml.find("<testsuite ", pos)) != std::string::npos)
+    {
+        std::string::size_type tag_end = xml.find(">", pos);
+        if (tag_end == std::string::npos) break;
+
+        std::string name = get_xml_attribute(xml.substr(pos, tag_end - pos), "name");
+        std::string::size_type suite_end = (xml[tag_end - 1] == '/') ?
+            tag_end : xml.find("</testsuite>", tag_end);
+        if (suite_end == std::string::npos) break;
+
+        auto suite = std::find_if(
+            suites->begin(), suites->end(),
+            [&](const suite_report_t &s) { return s.name == name; });
+        if (suite == suites->end())
+        {
+            suites->push_back(suite_report_t{ name, 0, 0, "" });
+            suite = suites->end() - 1;
+        }
+
+        for (pos = xml.find("<testcase ", tag_end);
+             pos < suite_end; pos = xml.find("<testcase ", pos))
+        {
+            std::string::size_type end = xml.find(">", pos);
+            std::string tag = xml.substr(pos, end - pos);
+            std::string::size_type case_end = (xml[end - 1] == '/') ?
+                end + 1 : xml.find("</testcase>", end) + 11;
+
+            if (get_xml_attribute(tag, "status") == "run")
+            {
+                std::string element = xml.substr(pos, case_end - pos);
+                ++suite->n_tests;
+                if (element.find("<failure") != std::string::npos)
+                    ++suite->n_failures;
+                suite->body += "\n    " + element;
+            }
+
+            pos = case_end;
+        }
+
+        pos = suite_end;
+    }
+
+    return true;
+}
+
+
+/**
+ * Runs the tests in n_jobs worker processes and merges their reports.
+ * Each worker runs a shard of the tests with its own KB directory,
+ * which is given to it through PHTEST_KB_DIR.
+ */
+int run_parallel(int argc, char **argv, int n_jobs)
+{
+    std::string dir = phtest::get_kb_dir();
+    std::vector<pid_t> pids(n_jobs);
+
+    mkdir(dir.c_str(), 0755);
+
+    for (int i = 0; i < n_jobs; ++i)
+    {
+        std::string shard_dir = dir + phil::format("/shard%d", i);
+        pids[i] = fork();
+
+        if (pids[i] < 0)
+        {
+            std::perror("fork");
+            for (int j = 0; j < i; ++j)
+                waitpid(pids[j], NULL, 0);
+            return 1;
+        }
+
+        if (pids[i] == 0)
+        {
+            mkdir(shard_dir.c_str(), 0755);
+            setenv("PHTEST_KB_DIR", shard_dir.c_str(), 1);
+            setenv("GTEST_TOTAL_SHARDS", phil::format("%d", n_jobs).c_str(), 1);
+            setenv("GTEST_SHARD_INDEX", phil::format("%d", i).c_str(), 1);
+
+            int fd = open(
+                (shard_dir + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+            close(fd);
+
+            std::string output = "--gtest_output=xml:" + shard_dir + ".xml";
+            std::vector<char*> args(argv, argv + argc);
+            args.push_back(&output[0]);
+            args.push_back(NULL);
+
+            // Executes itself again, so that the static state such as KB_PATH
+            // is initialized with the environment of this worker.
+            execvp(argv[0], &args[0]);
+            std::perror("execvp");
+            std::exit(1);
+        }
+    }
+
+    std::vector<suite_report_t> suites;
+    int n_crashed(0);
+
+    for (int i = 0; i < n_jobs; ++i)
+    {
+        std::string shard_dir = dir + phil::format("/shard%d", i);
+        int status;
+
+        waitpid(pids[i], &status, 0);
+        if (WIFSIGNALED(status))
+        {
+            std::printf("[  CRASHED ] shard %d (signal %d), see %s.log\n",
+                        i, WTERMSIG(status), shard_dir.c_str());
+            ++n_crashed;
+            continue;
+        }
+
+        std::ifstream fin(shard_dir + ".xml");
+        std::stringstream xml;
+        xml << fin.rdbuf();
+
+        if (not fin or not merge_xml_report(xml.str(), &suites))
+        {
+            if (WEXITSTATUS(status) != 0)
+            {
+                std::printf("[  CRASHED ] shard %d (exit %d), see %s.log\n",
+                            i, WEXITSTATUS(status), shard_dir.c_str());
+                ++n_crashed;
+            }
+            continue;
+        }
+
+        std::ifstream log(shard_dir + ".log");
+        for (std::string line; std::getline(log, line);)
+            if (line.compare(0, 12, "[  FAILED  ]") == 0 and
+                line.find(" ms)") == std::string::npos and
+                line.find(" test") == std::string::npos)
+                std::printf("%s\n", line.c_str());
+    }
+
+    int n_tests(0), n_failures(0);
+    std::string body;
+
+    for (const auto &suite : suites)
+    {
+        if (suite.n_tests == 0) continue;
+
+        n_tests += suite.n_tests;
+        n_failures += suite.n_failures;
+        body += phil::format(
+            "\n  <testsuite name=\"%s\" tests=\"%d\" failures=\"%d\" errors=\"0\">",
+            suite.name.c_str(), suite.n_tests, suite.n_failures);
+        body += suite.body + "\n  </testsuite>";
+    }
+
+    std::ofstream fout(dir + "/parallel.xml");
+    fout
+        << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<testsuites tests=\"" << n_tests
+        << "\" failures=\"" << n_failures
+        << "\" errors=\"0\" name=\"AllTests\">" << body << "\n</testsuites>\n";
+
+    std::printf(
+        "[==========] %d tests ran in %d processes. (report: %s/parallel.xml)\n",
+        n_tests, n_jobs, dir.c_str());
+    std::printf("[  PASSED  ] %d tests.\n", n_tests - n_failures);
+    if (n_failures > 0)
+        std::printf("[  FAILED  ] %d tests.\n", n_failures);
+
+    return (n_failures + n_crashed > 0) ? 1 : 0;
+}
+
+
+/** Returns the value of option "--key=value", or `def` if it is not given. */
+std::string get_option(
+    const std::map<std::string, std::string> &opts,
+    const std::string &key, const std::string &def)
+{
+    auto it = opts.find(key);
+    return (it != opts.end()) ? it->second : def;
+}
+
+
+/**
+ * Replays observations in a file with a compiled KB, one by one,
+ * and reports throughput, percentiles of latencies and the slowest documents.
+ * The file is in the input format of Phillip and is read as a stream.
+ */
+int run_replay(const std::map<std::string, std::string> &opts)
+{
+    using namespace phtest;
+
+    std::vector<std::string> solvers = get_solver_keys();
+    std::string path = get_option(opts, "replay", "");
+    std::string kb_path = get_option(opts, "kb", get_kb_dir() + "/kb");
+    std::string key_dist = get_option(opts, "dist", "basic");
+    std::string key_table = get_option(opts, "table", "null");
+    std::string key_lhs = get_option(opts, "lhs", "a*");
+    std::string key_ilp = get_option(opts, "ilp", "weighted");
+    std::string key_sol = get_option(
+        opts, "sol", solvers.empty() ? "null" : solvers.front());
+    std::string max_dist = get_option(opts, "max-distance", "4.0");
+    size_t n_slowest = std::atoi(get_option(opts, "slowest", "10").c_str());
+
+    std::ifstream fin(path);
+    if (not fin)
+    {
+        std::fprintf(stderr, "Cannot read \"%s\".\n", path.c_str());
+        return 1;
+    }
+
+    phillip_main_t::set_verbose(NOT_VERBOSE);
+    kb::knowledge_base_t::setup(kb_path, std::atof(max_dist.c_str()), 1, false);
+    kb::kb()->set_distance_provider(key_dist);
+    kb::kb()->set_category_table(key_table);
+
+    phillip_main_t phillip;
+    phillip.set_param("max_distance", max_dist);
+    setup_phillip(&phillip, key_lhs, key_ilp, key_sol);
+    if (not phillip.check_validity())
+    {
+        std::fprintf(stderr, "Invalid components: %s, %s, %s\n",
+                     key_lhs.c_str(), key_ilp.c_str(), key_sol.c_str());
+        return 1;
+    }
+
+    std::vector<infer_profile_t> profiles;
+    auto begin = std::chrono::steady_clock::now();
+
+    parse_input_stream(fin, [&](const lf::input_t &input)
+    {
+        string_hash_t::reset_unknown_hash_count();
+        profiles.push_back(profile_infer(&phillip, input));
+    });
+
+    double elapsed = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - begin).count();
+    std::vector<double> latencies;
+    for (const auto &p : profiles)
+        latencies.push_back(p.wall_infer);
+
+    std::printf("[  REPLAY  ] %zu documents in %.3f sec (%.2f docs/sec)\n",
+                profiles.size(), elapsed,
+                (elapsed > 0.0) ? profiles.size() / elapsed : 0.0);
+    for (double p : { 50.0, 90.0, 99.0, 100.0 })
+        std::printf("[  REPLAY  ] %-4s %.6f sec\n",
+                    (p < 100.0) ? format("p%g", p).c_str() : "max",
+                    get_percentile(&latencies, p));
+
+    std::sort(
+        profiles.begin(), profiles.end(),
+        [](const infer_profile_t &a, const infer_profile_t &b)
+        { return a.wall_infer > b.wall_infer; });
+    profiles.resize(std::min(profiles.size(), n_slowest));
+
+    for (const auto &p : profiles)
+        std::printf(
+            "[  SLOW    ] %s: %.6f sec (lhs %.6f, ilp %.6f, sol %.6f),"
+            " %zu nodes, %zu edges, %zu variables, %zu constraints\n",
+            p.name.c_str(), p.wall_infer, p.wall_lhs, p.wall_ilp, p.wall_sol,
+            p.num_nodes, p.num_edges, p.num_variables, p.num_constraints);
+
+    return 0;
+}
+
 
 int main(int argc, char **argv)
 {
+    std::map<std::string, std::string> opts;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *eq = std::strchr(argv[i], '=');
+        if (std::strncmp(argv[i], "--", 2) == 0 and eq != NULL)
+            opts[std::string(argv[i] + 2, eq - argv[i] - 2)] = eq + 1;
+    }
+
+    if (opts.count("replay") > 0)
+        return run_replay(opts);
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--jobs", 6) != 0 or
+            (argv[i][6] != '\0' and argv[i][6] != '=')) continue;
+
+        long n_jobs = sysconf(_SC_NPROCESSORS_ONLN);
+        if (argv[i][6] == '=')
+        {
+            char *end;
+            n_jobs = std::strtol(argv[i] + 7, &end, 10);
+            if (end == argv[i] + 7 or *end != '\0') n_jobs = 0;
+        }
+
+        if (n_jobs < 1)
+        {
+            std::fprintf(stderr,
+                "Invalid option \"%s\". Usage: --jobs[=N] where N >= 1.\n", argv[i]);
+            return 1;
+        }
+
+        for (int j = i; j < argc; ++j)
+            argv[j] = argv[j + 1];
+        --argc;
+
+        return run_parallel(argc, argv, static_cast<int>(n_jobs));
+    }
+
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
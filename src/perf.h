@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstring>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+
+namespace phtest
+{
+
+
+/** Values of hardware counters. A value is -1 if its counter is unavailable. */
+struct perf_stat_t
+{
+    perf_stat_t()
+        : cycles(-1), instructions(-1), cache_misses(-1), branch_misses(-1) {}
+
+    bool is_valid() const
+    {
+        return
+            cycles >= 0 or instructions >= 0 or
+            cache_misses >= 0 or branch_misses >= 0;
+    }
+
+    /**
+     * Returns the difference of each counter.
+     * It is -1 if either is unavailable or if the difference is negative,
+     * which means the two values came from runs too noisy to be compared.
+     */
+    perf_stat_t operator-(const perf_stat_t &x) const
+    {
+        perf_stat_t out;
+        out.cycles = sub(cycles, x.cycles);
+        out.instructions = sub(instructions, x.instructions);
+        out.cache_misses = sub(cache_misses, x.cache_misses);
+        out.branch_misses = sub(branch_misses, x.branch_misses);
+        return out;
+    }
+
+    long long cycles, instructions, cache_misses, branch_misses;
+
+private:
+    static long long sub(long long a, long long b)
+    {
+        return (a >= 0 and b >= 0 and a >= b) ? a - b : -1;
+    }
+};
+
+
+/**
+ * Hardware counters of this process opened with perf_event_open.
+ * Threads created after construction are counted too.
+ * Counters which cannot be opened (e.g. on other platforms, in containers
+ * or with perf_event_paranoid > 2) are reported as -1.
+ */
+class perf_counter_t
+{
+public:
+    perf_counter_t()
+    {
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+            m_fd[i] = open(i);
+    }
+
+    ~perf_counter_t()
+    {
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+            if (m_fd[i] >= 0) close(m_fd[i]);
+    }
+
+    perf_counter_t(const perf_counter_t&) = delete;
+    perf_counter_t& operator=(const perf_counter_t&) = delete;
+
+    bool is_available() const
+    {
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+            if (m_fd[i] >= 0) return true;
+        return false;
+    }
+
+    void start()
+    {
+#ifdef __linux__
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            if (m_fd[i] < 0) continue;
+            ioctl(m_fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    perf_stat_t stop()
+    {
+        long long values[NUM_COUNTERS];
+
+        for (int i = 0; i < NUM_COUNTERS; ++i)
+        {
+            values[i] = -1;
+#ifdef __linux__
+            if (m_fd[i] < 0) continue;
+            ioctl(m_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            unsigned long long v;
+            if (read(m_fd[i], &v, sizeof(v)) == sizeof(v))
+                values[i] = static_cast<long long>(v);
+#endif
+        }
+
+        perf_stat_t out;
+        out.cycles = values[0];
+        out.instructions = values[1];
+        out.cache_misses = values[2];
+        out.branch_misses = values[3];
+        return out;
+    }
+
+private:
+    enum { NUM_COUNTERS = 4 };
+
+    static int open(int i)
+    {
+#ifdef __linux__
+        static const unsigned long long CONFIGS[NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+        struct perf_event_attr attr;
+
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = CONFIGS[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        return -1;
+#endif
+    }
+
+    int m_fd[NUM_COUNTERS];
+};
+
+
+}
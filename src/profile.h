@@ -0,0 +1,236 @@
+#pragma once
+
+#include <ctime>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <phillip.h>
+
+#include "./test.h"
+#include "./alloc.h"
+#include "./perf.h"
+
+
+namespace phtest
+{
+
+using namespace phil;
+
+
+/** Measurements of one call of phillip_main_t::infer. */
+struct infer_profile_t
+{
+    std::string name; // Name of the input.
+
+    // Wall-clock time of each phase in seconds, measured by Phillip.
+    double wall_lhs, wall_ilp, wall_sol, wall_infer;
+
+    // CPU time of the whole inference in seconds, summed over all threads.
+    double cpu_infer;
+
+    size_t num_nodes, num_edges;
+    size_t num_variables, num_constraints;
+
+    // Allocations during the inference.
+    alloc_stat_t alloc;
+
+    // Hardware counters, given only by profile_infer_phases.
+    // Those of phases are estimates from separate runs, and those of KB queries
+    // are of a replay of queries, not of the queries made in the inference.
+    perf_stat_t perf_kb_replay, perf_lhs_est, perf_ilp_est, perf_sol_est;
+};
+
+
+/** Calls phillip->infer(input) and returns measurements of it. */
+inline infer_profile_t profile_infer(phillip_main_t *phillip, const lf::input_t &input)
+{
+    infer_profile_t prof;
+    alloc_scope_t scope;
+    std::clock_t begin = std::clock();
+
+    phillip->infer(input);
+
+    prof.alloc = scope.stat();
+    prof.name = input.name;
+    prof.cpu_infer = static_cast<double>(std::clock() - begin) / CLOCKS_PER_SEC;
+    prof.wall_lhs = phillip->get_time_for_lhs();
+    prof.wall_ilp = phillip->get_time_for_ilp();
+    prof.wall_sol = phillip->get_time_for_sol();
+    prof.wall_infer = phillip->get_time_for_infer();
+
+    const pg::proof_graph_t *graph = phillip->get_latent_hypotheses_set();
+    const ilp::ilp_problem_t *prob = phillip->get_ilp_problem();
+
+    prof.num_nodes = (graph != NULL) ? graph->nodes().size() : 0;
+    prof.num_edges = (graph != NULL) ? graph->edges().size() : 0;
+    prof.num_variables = (prob != NULL) ? prob->variables().size() : 0;
+    prof.num_constraints = (prob != NULL) ? prob->constraints().size() : 0;
+
+    return prof;
+}
+
+
+/**
+ * Runs the pipeline of given components up to each phase in a child process
+ * and returns hardware counters of them, which are cumulative over phases.
+ * The state of phillip is not changed.
+ */
+inline std::vector<perf_stat_t> perf_partial_pipelines(
+    phillip_main_t *phillip,
+    const std::string &key_lhs, const std::string &key_ilp,
+    const lf::input_t &input)
+{
+    std::vector<perf_stat_t> out;
+    int fd[2];
+
+    if (pipe(fd) != 0) return out;
+    std::fflush(stdout);
+
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        close(fd[0]);
+        perf_counter_t counter;
+        perf_stat_t stats[2];
+
+        for (int i = 0; i < 2; ++i)
+        {
+            setup_phillip(phillip, key_lhs, (i == 0) ? "null" : key_ilp, "null");
+            counter.start();
+            phillip->infer(input);
+            stats[i] = counter.stop();
+        }
+
+        if (write(fd[1], stats, sizeof(stats)) != sizeof(stats))
+            _exit(1);
+        _exit(0);
+    }
+
+    close(fd[1]);
+    if (pid > 0)
+    {
+        perf_stat_t stats[2];
+        if (read(fd[0], stats, sizeof(stats)) == sizeof(stats))
+            out.assign(stats, stats + 2);
+        waitpid(pid, NULL, 0);
+    }
+    close(fd[0]);
+
+    return out;
+}
+
+
+/**
+ * Calls phillip->infer(input) as profile_infer does,
+ * and also estimates hardware counters of each phase.
+ * Phillip has no hook between phases, so the counters of the enumeration
+ * and the conversion are taken from partial pipelines run in a child process,
+ * and each phase is estimated as the difference from the previous one.
+ * Since the runs differ in cache warmth, a negative difference is left -1.
+ * The counters of KB queries are of a replay of distance queries
+ * among the predicates of the resulting proof graph.
+ * Counters are left -1 when they are unavailable.
+ */
+inline infer_profile_t profile_infer_phases(
+    phillip_main_t *phillip,
+    const std::string &key_lhs, const std::string &key_ilp,
+    const lf::input_t &input)
+{
+    const size_t MAX_ARITIES = 256;
+
+    if (not perf_counter_t().is_available())
+        return profile_infer(phillip, input);
+
+    std::vector<perf_stat_t> partial =
+        perf_partial_pipelines(phillip, key_lhs, key_ilp, input);
+
+    perf_counter_t counter;
+    counter.start();
+    infer_profile_t prof = profile_infer(phillip, input);
+    perf_stat_t all = counter.stop();
+
+    if (partial.size() == 2)
+    {
+        prof.perf_lhs_est = partial[0];
+        prof.perf_ilp_est = partial[1] - partial[0];
+        prof.perf_sol_est = all - partial[1];
+    }
+
+    const pg::proof_graph_t *graph = phillip->get_latent_hypotheses_set();
+    if (graph != NULL)
+    {
+        std::set<std::string> set;
+        for (const auto &node : graph->nodes())
+            if (set.size() < MAX_ARITIES)
+                set.insert(node.literal().get_arity());
+
+        std::vector<std::string> arities(set.begin(), set.end());
+        float sum(0.0f);
+
+        counter.start();
+        for (const auto &a1 : arities)
+            for (const auto &a2 : arities)
+                sum += kb::kb()->get_distance(a1, a2);
+        prof.perf_kb_replay = counter.stop();
+        (void)sum;
+    }
+
+    return prof;
+}
+
+
+/** Returns a JSON object which holds the values of hardware counters. */
+inline std::string to_json(const perf_stat_t &p)
+{
+    std::string out;
+    const long long values[] =
+        { p.cycles, p.instructions, p.cache_misses, p.branch_misses };
+    const char *keys[] =
+        { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+    for (int i = 0; i < 4; ++i)
+        out += format("%s\"%s\": %s", (i > 0) ? ", " : "", keys[i],
+                      (values[i] >= 0) ? format("%lld", values[i]).c_str() : "null");
+
+    return "{" + out + "}";
+}
+
+
+/** Returns a JSON object which holds the profiles of a test case. */
+inline std::string to_json(
+    const std::string &test_name, const std::vector<infer_profile_t> &profiles)
+{
+    std::string out = format("{\"test\": \"%s\", \"infer\": [", test_name.c_str());
+
+    for (size_t i = 0; i < profiles.size(); ++i)
+    {
+        const infer_profile_t &p = profiles[i];
+        out += format(
+            "%s{\"input\": \"%s\", "
+            "\"wall\": {\"lhs\": %.6f, \"ilp\": %.6f, \"sol\": %.6f, \"all\": %.6f}, "
+            "\"cpu\": {\"all\": %.6f}, "
+            "\"graph\": {\"nodes\": %zu, \"edges\": %zu}, "
+            "\"ilp\": {\"variables\": %zu, \"constraints\": %zu}, "
+            "\"alloc\": {\"count\": %zu, \"bytes\": %zu, \"peak\": %zu}",
+            (i > 0) ? ", " : "", p.name.c_str(),
+            p.wall_lhs, p.wall_ilp, p.wall_sol, p.wall_infer, p.cpu_infer,
+            p.num_nodes, p.num_edges, p.num_variables, p.num_constraints,
+            p.alloc.num_alloc, p.alloc.bytes_alloc, p.alloc.peak_live);
+
+        if (p.perf_kb_replay.is_valid() or p.perf_lhs_est.is_valid())
+            out += format(
+                ", \"perf\": {\"kb_replay\": %s, \"lhs_est\": %s,"
+                " \"ilp_est\": %s, \"sol_est\": %s}",
+                to_json(p.perf_kb_replay).c_str(), to_json(p.perf_lhs_est).c_str(),
+                to_json(p.perf_ilp_est).c_str(), to_json(p.perf_sol_est).c_str());
+
+        out += "}";
+    }
+
+    return out + "]}";
+}
+
+
+}
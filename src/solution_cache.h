@@ -0,0 +1,81 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include "./test.h"
+#include "./fingerprint.h"
+
+
+namespace phtest
+{
+
+using namespace phil;
+
+
+/** A solution held by solution_cache_t. */
+struct cached_solution_t
+{
+    std::string text; // Canonical text of active nodes and edges.
+    double objective;
+};
+
+
+/**
+ * A memo of ILP solutions for documents seen before.
+ * Solvers of Phillip cannot take a previous solution as a warm start,
+ * and the ILP problem cannot be split into parts reusable across documents,
+ * so only a document identical to one inferred before can reuse its solution.
+ * A key covers the observation, the requirement and the configuration,
+ * so a hit needs no inference at all.
+ */
+class solution_cache_t
+{
+public:
+    solution_cache_t() : m_num_hit(0), m_num_miss(0) {}
+
+    /**
+     * Returns the key of an input.
+     * @param config Keys of components and parameters which affect the solution.
+     */
+    static unsigned long long get_key(
+        const lf::input_t &input, const std::string &config)
+    {
+        return get_fingerprint(
+            config + "\n" + input.obs.to_string() + "\n" + input.req.to_string());
+    }
+
+    /** Returns the solution of the input with the key, or NULL. */
+    const cached_solution_t* find(unsigned long long key)
+    {
+        auto found = m_solutions.find(key);
+
+        if (found == m_solutions.end())
+        {
+            ++m_num_miss;
+            return NULL;
+        }
+
+        ++m_num_hit;
+        return &found->second;
+    }
+
+    void insert(
+        unsigned long long key,
+        const ilp::ilp_problem_t *prob, const ilp::ilp_solution_t &sol)
+    {
+        cached_solution_t &c = m_solutions[key];
+        c.text = canonical_writer_t().write(prob, sol);
+        c.objective = sol.value_of_objective_function();
+    }
+
+    size_t num_hit() const { return m_num_hit; }
+    size_t num_miss() const { return m_num_miss; }
+
+private:
+    std::unordered_map<unsigned long long, cached_solution_t> m_solutions;
+    size_t m_num_hit, m_num_miss;
+};
+
+
+}
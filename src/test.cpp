@@ -1,5 +1,15 @@
+#include <chrono>
+#include <fstream>
 #include <list>
+#include <sstream>
 #include "./test.h"
+#include "./generator.h"
+#include "./distance.h"
+#include "./profile.h"
+#include "./perf.h"
+#include "./alloc.h"
+#include "./fingerprint.h"
+#include "./solution_cache.h"
 
 namespace phtest
 {
@@ -7,7 +17,12 @@ namespace phtest
 using namespace phil;
 
 
-const std::string KB_PATH = "compiled/kb";
+const std::string KB_PATH = get_kb_dir() + "/kb";
+
+// Budgets of peak memory, which are loose upper bounds
+// to catch regressions of an order of magnitude.
+const size_t MAX_PEAK_BYTES_PER_AXIOM = 16 * 1024;
+const size_t MAX_PEAK_BYTES_PER_NODE = 64 * 1024;
 
 
 TEST(UtilityTest, StringHash)
@@ -39,6 +54,54 @@ TEST(UtilityTest, Literal)
 }
 
 
+TEST(UtilityTest, ParseStream)
+{
+    std::istringstream in(
+        "; (=> (commented-out x) (axiom x))\n"
+        "(=> (dog-n x) (animal-n x))\n"
+        "(xor (dog-n x)\n"
+        "     (cat-n x))"
+        "(unipp (nsubj * .))");
+    std::vector<lf::logical_function_t> funcs;
+    int n = parse_stream(in, [&funcs](const lf::logical_function_t &func)
+    {
+        funcs.push_back(func);
+    });
+
+    ASSERT_EQ(3, n);
+    ASSERT_EQ(3, funcs.size());
+    EXPECT_TRUE(funcs.at(0).is_operator(lf::OPR_IMPLICATION));
+    EXPECT_TRUE(funcs.at(1).is_operator(lf::OPR_INCONSISTENT));
+    EXPECT_TRUE(funcs.at(2).is_operator(lf::OPR_UNIPP));
+}
+
+
+TEST(UtilityTest, ParseInputStream)
+{
+    std::istringstream in(
+        "(O (name first)\n"
+        "   (^ (dog-n X) (bark-v E1) (nsubj E1 X)))\n"
+        "; (O (name commented-out) (^ (cat-n Y)))\n"
+        "(O (name second) (^ (cat-n Y)))"
+        "(^ (die-v E2) (nsubj E2 Z))");
+    std::vector<lf::input_t> inputs;
+    int n = parse_input_stream(in, [&inputs](const lf::input_t &input)
+    {
+        inputs.push_back(input);
+    });
+
+    ASSERT_EQ(3, n);
+    ASSERT_EQ(3, inputs.size());
+    EXPECT_EQ("first", inputs.at(0).name);
+    EXPECT_EQ("second", inputs.at(1).name);
+    EXPECT_EQ("doc2", inputs.at(2).name);
+    EXPECT_TRUE(inputs.at(0).obs.is_operator(lf::OPR_AND));
+    EXPECT_EQ(3, inputs.at(0).obs.branches().size());
+    EXPECT_EQ(1, inputs.at(1).obs.branches().size());
+    EXPECT_EQ(2, inputs.at(2).obs.branches().size());
+}
+
+
 TEST(CompileKBTest, BasicDistance)
 {
     setup_kb(KB_PATH, "basic", "null", 4.0f);
@@ -159,7 +222,139 @@ TEST(CompileKBTest, BasicCategoryTable)
 }
 
 
-/** A fixture class for testing inference with Phillip. */
+TEST(GeneratorTest, Deterministic)
+{
+    for (auto shape : { SHAPE_CHAIN, SHAPE_TAXONOMY, SHAPE_EVENT })
+    {
+        generator_t gen1(kb_config_t(shape, 100), 1);
+        generator_t gen2(kb_config_t(shape, 100), 1);
+
+        EXPECT_EQ(gen1.implications(), gen2.implications());
+        EXPECT_EQ(gen1.inconsistencies(10), gen2.inconsistencies(10));
+        EXPECT_EQ(gen1.observation(30), gen2.observation(30));
+
+        std::list<lf::logical_function_t> funcs;
+        lf::parse(gen1.implications(), &funcs);
+        EXPECT_EQ(100, funcs.size());
+
+        funcs.clear();
+        lf::parse(gen1.inconsistencies(10), &funcs);
+        EXPECT_EQ(10, funcs.size());
+    }
+
+    generator_t gen1(kb_config_t(SHAPE_EVENT, 100), 1);
+    generator_t gen2(kb_config_t(SHAPE_EVENT, 100), 2);
+    EXPECT_NE(gen1.implications(), gen2.implications());
+}
+
+
+TEST(CompileKBTest, GeneratedTaxonomy)
+{
+    int n = get_test_scale();
+    generator_t gen(kb_config_t(SHAPE_TAXONOMY, n));
+    std::string imp = gen.implications();
+    std::string inc = gen.inconsistencies(n / 100);
+    alloc_scope_t scope;
+
+    setup_kb(KB_PATH, "basic", "null", 4.0f);
+    ASSERT_TRUE(kb::kb()->is_writable());
+
+    EXPECT_EQ(n, insert_implications(imp));
+    insert_inconsistencies(inc);
+    insert_unification_postponements(gen.unification_postponements());
+
+    kb::kb()->finalize();
+    kb::kb()->prepare_query();
+
+    EXPECT_GE(MAX_PEAK_BYTES_PER_AXIOM * n, scope.stat().peak_live);
+
+    EXPECT_NE(kb::INVALID_AXIOM_ID, kb::kb()->search_arity_id("t0/1"));
+    EXPECT_NE(kb::INVALID_AXIOM_ID, kb::kb()->search_arity_id(format("t%d/1", n)));
+    EXPECT_EQ(1.0f, kb::kb()->get_distance("t1/1", "t0/1"));
+    EXPECT_EQ(2.0f, kb::kb()->get_distance("t9/1", "t0/1"));
+}
+
+
+TEST(CompileKBTest, ParallelFinalize)
+{
+    const int NUM_ARITIES = 100;
+    int n = get_test_scale();
+    std::string imp = generator_t(kb_config_t(SHAPE_TAXONOMY, n)).implications();
+    std::vector<std::string> arities;
+    std::string expected;
+
+    for (int i = 0; i < NUM_ARITIES; ++i)
+        arities.push_back(format("t%d/1", i * n / (NUM_ARITIES - 1)));
+
+    for (int n_thread : { 1, 4 })
+    {
+        setup_kb(KB_PATH + format("_th%d", n_thread), "basic", "basic", 4.0f, n_thread);
+        insert_implications(imp);
+        kb::kb()->finalize();
+        kb::kb()->prepare_query();
+
+        std::string text = get_kb_query_text(arities);
+        if (n_thread == 1)
+            expected = text;
+        else
+            EXPECT_EQ(expected, text)
+                << "Answers with " << n_thread << " threads differ";
+    }
+}
+
+
+TEST(CompileKBTest, DistanceCache)
+{
+    generator_t gen(kb_config_t(SHAPE_TAXONOMY, 100));
+
+    setup_kb(KB_PATH, "basic", "null", 4.0f);
+    insert_implications(gen.implications());
+    kb::kb()->finalize();
+    kb::kb()->prepare_query();
+
+    distance_cache_t cache(64);
+    std::vector<std::string> arities;
+    std::vector<distance_cache_t::arity_pair_t> pairs;
+
+    std::vector<kb::arity_id_t> ids;
+
+    for (int i = 0; i <= 100; ++i)
+    {
+        arities.push_back(format("t%d/1", i));
+        ids.push_back(cache.search(arities.back()));
+        ASSERT_NE(kb::INVALID_AXIOM_ID, ids.back());
+        ASSERT_EQ(kb::kb()->search_arity_id(arities.back()), ids.back());
+    }
+
+    for (auto id1 : ids)
+        for (auto id2 : ids)
+            pairs.push_back(std::make_pair(id1, id2));
+
+    // Queries all pairs twice, so that the latter half may hit the cache.
+    for (int n = 0; n < 2; ++n)
+    {
+        std::vector<float> dists;
+        cache.get(pairs, &dists);
+
+        for (size_t i = 0; i < dists.size(); ++i)
+            EXPECT_EQ(kb::kb()->get_distance(
+                          arities[i / arities.size()], arities[i % arities.size()]),
+                      dists[i]);
+    }
+
+    EXPECT_EQ(2 * pairs.size(), cache.num_hit() + cache.num_miss());
+
+    // An id which search() has not given is not resolved, and does not throw.
+    distance_cache_t empty;
+    EXPECT_EQ(-1.0f, empty.get(ids[0], ids[1]));
+}
+
+
+/**
+ * A fixture class for testing inference with Phillip.
+ * Every inference is profiled, and if PHTEST_PROFILE is set,
+ * the profiles of each test are appended to the file as a line of JSON.
+ */
 class PhillipTest :
         public phillip_main_t,
         public ::testing::Test
@@ -170,6 +365,31 @@ protected:
             string_hash_t::reset_unknown_hash_count();
             set_verbose(NOT_VERBOSE);
             set_param("max_distance", "4.0");
+            m_profiles.clear();
+        }
+
+    virtual void TearDown() override
+        {
+            const char *path = std::getenv("PHTEST_PROFILE");
+            if (path == NULL or m_profiles.empty()) return;
+
+            const ::testing::TestInfo *info =
+                ::testing::UnitTest::GetInstance()->current_test_info();
+            std::ofstream fout(path, std::ios::app);
+            fout << to_json(
+                format("%s.%s", info->test_case_name(), info->name()),
+                m_profiles) << std::endl;
+        }
+
+    void infer(const lf::input_t &input)
+        {
+            // HARDWARE COUNTERS ARE MEASURED ONLY ON DEMAND,
+            // SINCE THEY NEED EXTRA INFERENCES OF PARTIAL PIPELINES.
+            if (std::getenv("PHTEST_PERF") != NULL and not m_key_lhs.empty())
+                m_profiles.push_back(
+                    profile_infer_phases(this, m_key_lhs, m_key_ilp, input));
+            else
+                m_profiles.push_back(profile_infer(this, input));
         }
 
     void setup_phillip(
@@ -177,31 +397,27 @@ protected:
         const std::string &key_ilp,
         const std::string &key_sol)
         {
-            set_lhs_enumerator(
-                bin::lhs_enumerator_library_t::instance()
-                ->generate(key_lhs, this));
-            set_ilp_convertor(
-                bin::ilp_converter_library_t::instance()
-                ->generate(key_ilp, this));
-            set_ilp_solver(
-                bin::ilp_solver_library_t::instance()
-                ->generate(key_sol, this));
-            kb::kb()->prepare_query();
+            phtest::setup_phillip(this, key_lhs, key_ilp, key_sol);
+            m_key_lhs = key_lhs;
+            m_key_ilp = key_ilp;
         }
+
+    std::vector<infer_profile_t> m_profiles;
+    std::string m_key_lhs, m_key_ilp;
 };
 
 
 TEST_F(PhillipTest, DepthBasedEnumerator)
 {
-    setup_kb(KB_PATH, "basic", "null", 4.0f);
-    insert_implications(
+    setup_shared_kb(
+        "basic", "null", 4.0f,
         "(=> (dog-n x) (animal-n x))"
         "(=> (cat-n x) (animal-n x))"
         "(=> (^ (kill-v *e1) (nsubj *e1 u) (dobj *e1 x))"
         "    (^ (die-v *e2) (nsubj *e2 x)))"
         "(=> (^ (hate-v *e1) (nsubj *e1 x) (dobj *e1 y))"
-        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))");
-    insert_unification_postponements(
+        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))",
+        "",
         "(unipp (nsubj * .))"
         "(unipp (dobj * .))");
 
@@ -256,15 +472,15 @@ TEST_F(PhillipTest, DepthBasedEnumerator)
 
 TEST_F(PhillipTest, AStarBasedEnumerator)
 {
-    setup_kb(KB_PATH, "basic", "null", 4.0f);
-    insert_implications(
+    setup_shared_kb(
+        "basic", "null", 4.0f,
         "(=> (dog-n x) (animal-n x))"
         "(=> (cat-n x) (animal-n x))"
         "(=> (^ (kill-v *e1) (nsubj *e1 u) (dobj *e1 x))"
         "    (^ (die-v *e2) (nsubj *e2 x)))"
         "(=> (^ (hate-v *e1) (nsubj *e1 x) (dobj *e1 y))"
-        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))");
-    insert_unification_postponements(
+        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))",
+        "",
         "(unipp (nsubj * .))"
         "(unipp (dobj * .))");
 
@@ -313,19 +529,70 @@ TEST_F(PhillipTest, AStarBasedEnumerator)
 }
 
 
-TEST_F(PhillipTest, Weighted)
+TEST_F(PhillipTest, CanonicalGraph)
 {
-    setup_kb(KB_PATH, "basic", "null", 4.0f);
-    insert_implications(
+    setup_shared_kb(
+        "basic", "null", 4.0f,
+        "(=> (dog-n x) (animal-n x))"
+        "(=> (cat-n x) (animal-n x))"
+        "(=> (^ (kill-v *e1) (nsubj *e1 u) (dobj *e1 x))"
+        "    (^ (die-v *e2) (nsubj *e2 x)))"
+        "(=> (^ (hate-v *e1) (nsubj *e1 x) (dobj *e1 y))"
+        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))",
+        "",
+        "(unipp (nsubj * .))"
+        "(unipp (dobj * .))");
+
+    setup_phillip("depth", "null", "null");
+    ASSERT_TRUE(check_validity());
+
+    lf::input_t input = make_input(
+        "Test1",
+        "(^ (hate-v E1) (nsubj E1 John) (dobj E1 Tom)"
+        "   (die-v E2) (nsubj E2 Tom) (animal-n A))");
+
+    // Unknowns of the second inference are numbered after those of the first.
+    infer(input);
+    std::string text1 = get_canonical_text(get_latent_hypotheses_set());
+    std::string nodes1 = canonical_writer_t().write_nodes(get_latent_hypotheses_set());
+    infer(input);
+    std::string text2 = get_canonical_text(get_latent_hypotheses_set());
+
+    EXPECT_EQ(text1, text2);
+    EXPECT_EQ(get_fingerprint(text1), get_fingerprint(text2));
+    EXPECT_EQ(
+        "kill-v(_1)", canonical_writer_t().write(literal_t("kill-v", {"_u4"})));
+
+    // Only nodes are kept in the golden file,
+    // which are the same as those asserted in DepthBasedEnumerator.
+    EXPECT_TRUE(match_golden("depth_enumerator", nodes1));
+}
+
+
+/** A fixture class for testing inference with each ILP solver available. */
+class PhillipSolverTest :
+        public PhillipTest,
+        public ::testing::WithParamInterface<std::string>
+{};
+
+
+INSTANTIATE_TEST_CASE_P(
+    Solvers, PhillipSolverTest, ::testing::ValuesIn(get_solver_keys()));
+
+
+TEST_P(PhillipSolverTest, Weighted)
+{
+    setup_shared_kb(
+        "basic", "null", 4.0f,
         "(=> (^ (kill-v *e1) (nsubj *e1 u) (dobj *e1 x))"
         "    (^ (die-v *e2) (nsubj *e2 x)))"
         "(=> (^ (hate-v *e1) (nsubj *e1 x) (dobj *e1 y))"
-        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))");
-    insert_unification_postponements(
+        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))",
+        "",
         "(unipp (nsubj * .))"
         "(unipp (dobj * .))");
     
-    setup_phillip("a*", "weighted", "gurobi");
+    setup_phillip("a*", "weighted", GetParam());
     ASSERT_TRUE(check_validity());
 
     infer(make_input(
@@ -340,6 +607,13 @@ TEST_F(PhillipTest, Weighted)
     ASSERT_EQ(13, graph->nodes().size());
     ASSERT_EQ(ilp::SOLUTION_OPTIMAL, sol.type());
 
+    ASSERT_EQ(1, m_profiles.size());
+    EXPECT_EQ(graph->nodes().size(), m_profiles.front().num_nodes);
+    EXPECT_EQ(prob->variables().size(), m_profiles.front().num_variables);
+    EXPECT_EQ(prob->constraints().size(), m_profiles.front().num_constraints);
+    EXPECT_TRUE(match_golden(
+        "weighted_solution", canonical_writer_t().write(prob, sol)));
+
 #define EXPECT_EQ_LIT(idx, lit) EXPECT_EQ(lit, graph->node(idx).literal())
 #define EXPECT_EQ_DEPTH(idx, dep) EXPECT_EQ(dep, graph->node(idx).depth())
 #define EXPECT_NODE_ACTIVE(idx) \
@@ -408,20 +682,20 @@ TEST_F(PhillipTest, Weighted)
 }
 
 
-TEST_F(PhillipTest, Costed)
+TEST_P(PhillipSolverTest, Costed)
 {
-    setup_kb(KB_PATH, "basic", "null", 4.0f);
-    insert_implications(
+    setup_shared_kb(
+        "basic", "null", 4.0f,
         "(=> (^ (kill-v *e1) (nsubj *e1 u) (dobj *e1 x))"
         "    (^ (die-v *e2) (nsubj *e2 x)))"
         "(=> (^ (hate-v *e1) (nsubj *e1 x) (dobj *e1 y))"
-        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))");
-    insert_unification_postponements(
+        "    (^ (kill-v *e2) (nsubj *e2 x) (dobj *e2 y)))",
+        "",
         "(unipp (nsubj * .))"
         "(unipp (dobj * .))");
 
     set_param("cost_provider", "basic(10.0,-50.0,4.0)");
-    setup_phillip("a*", "costed", "gurobi");
+    setup_phillip("a*", "costed", GetParam());
     ASSERT_TRUE(check_validity());
 
     infer(make_input(
@@ -504,4 +778,104 @@ TEST_F(PhillipTest, Costed)
 }
 
 
+TEST_P(PhillipSolverTest, DuplicateDocuments)
+{
+    const int NUM_DOCS = 12;
+    const int NUM_VARIANTS = 4;
+    generator_t gen(kb_config_t(SHAPE_EVENT, 200));
+    std::string base = gen.observation(30), base_text;
+    std::string config = "a*|weighted|" + GetParam() + "|4.0";
+    solution_cache_t cache;
+    double time_cold(0.0), time_reuse(0.0);
+
+    auto elapsed = [](std::chrono::steady_clock::time_point begin)
+    {
+        return std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - begin).count();
+    };
+
+    setup_shared_kb(
+        "basic", "null", 4.0f,
+        gen.implications(), "", gen.unification_postponements());
+    setup_phillip("a*", "weighted", GetParam());
+
+    for (int i = 0; i < NUM_DOCS; ++i)
+    {
+        // DOCUMENTS ARE THE BASE OR THE BASE WITH AN EXTRA EVENT, IN TURN.
+        // VARIANTS DIFFER FROM THE BASE BY THREE LITERALS AND NEVER SHARE ITS SOLUTION.
+        int k = i % NUM_VARIANTS;
+        std::string obs = (k == 0) ? base :
+            base.substr(0, base.size() - 1) +
+            format(" (ev%d E99) (nsubj E99 X0) (dobj E99 X1))", k);
+        lf::input_t input = make_input(format("Doc%d", i), obs);
+
+        // THE PATH WITH THE MEMO: LOOKS UP THE KEY AND TAKES THE SOLUTION ON A HIT
+        auto begin = std::chrono::steady_clock::now();
+        unsigned long long key = solution_cache_t::get_key(input, config);
+        const cached_solution_t *cached = cache.find(key);
+        std::string reused = (cached != NULL) ? cached->text : "";
+        double time_lookup = elapsed(begin);
+
+        // INFERS IN ANY CASE TO CHECK THE MEMOIZED SOLUTION
+        infer(input);
+
+        const ilp::ilp_problem_t *prob = get_ilp_problem();
+        const ilp::ilp_solution_t &sol = get_solutions().front();
+        std::string text = canonical_writer_t().write(prob, sol);
+
+        ASSERT_EQ(ilp::SOLUTION_OPTIMAL, sol.type());
+        time_cold += get_time_for_infer();
+
+        if (cached != NULL)
+        {
+            EXPECT_EQ(reused, text);
+            EXPECT_NEAR(cached->objective, sol.value_of_objective_function(), 1e-6);
+            time_reuse += time_lookup;
+        }
+        else
+        {
+            begin = std::chrono::steady_clock::now();
+            cache.insert(key, prob, sol);
+            time_reuse += time_lookup + get_time_for_infer() + elapsed(begin);
+        }
+
+        if (k == 0)
+            base_text = text;
+        else
+            EXPECT_NE(base_text, text);
+    }
+
+    EXPECT_EQ(NUM_DOCS - NUM_VARIANTS, cache.num_hit());
+    EXPECT_EQ(NUM_VARIANTS, cache.num_miss());
+
+    RecordProperty("time_cold", format("%.6f", time_cold));
+    RecordProperty("time_reuse", format("%.6f", time_reuse));
+}
+
+
+TEST_F(PhillipTest, GeneratedEvents)
+{
+    generator_t gen(kb_config_t(SHAPE_EVENT, get_test_scale()));
+
+    setup_shared_kb(
+        "basic", "null", 4.0f,
+        gen.implications(), "", gen.unification_postponements());
+
+    setup_phillip("a*", "null", "null");
+    ASSERT_TRUE(check_validity());
+
+    infer(gen.input("Generated", 30));
+
+    const pg::proof_graph_t *graph = get_latent_hypotheses_set();
+    ASSERT_TRUE(graph != NULL);
+    EXPECT_LE(30, graph->nodes().size());
+    EXPECT_GE(MAX_PEAK_BYTES_PER_NODE * graph->nodes().size(),
+              m_profiles.front().alloc.peak_live);
+
+    // Each scale has its own golden file, and a missing one is a failure.
+    EXPECT_TRUE(match_golden(
+        format("generated_events_%d", get_test_scale()), get_canonical_text(graph)));
+}
+
+
 }
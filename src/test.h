@@ -1,5 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <istream>
+#include <map>
+#include <sstream>
+#include <functional>
 #include <gtest/gtest.h>
 #include <phillip.h>
 #include <binary.h>
@@ -11,21 +18,39 @@ namespace phtest
 using namespace phil;
 
 
-void setup_kb(
+/**
+ * Returns the directory where tests write compiled KBs.
+ * It is given by PHTEST_KB_DIR, so that KBs can be put on tmpfs.
+ */
+inline std::string get_kb_dir()
+{
+    const char *env = std::getenv("PHTEST_KB_DIR");
+    return (env != NULL) ? env : "compiled";
+}
+
+
+/**
+ * Sets up a new KB to compile.
+ * @param num_threads Number of threads which finalize() uses to precompute distances.
+ */
+inline void setup_kb(
     const std::string &filename,
     const std::string &key_dist,
     const std::string &key_table,
-    float max_dist)
+    float max_dist,
+    int num_threads = 1)
 {
     phillip_main_t::set_verbose(NOT_VERBOSE);
-    kb::knowledge_base_t::setup(filename, max_dist, 1, false);
+    kb::knowledge_base_t::setup(filename, max_dist, num_threads, false);
     kb::kb()->set_distance_provider(key_dist);
     kb::kb()->set_category_table(key_table);
     kb::kb()->prepare_compile();
 }
 
 
-int insert_implications(const std::string &str)
+/** Inserts implications named `prefix` followed by their index in `str`. */
+inline int insert_implications(
+    const std::string &str, const std::string &prefix = "imp_")
 {
     int n_imp(0);
     std::list<lf::logical_function_t> funcs;
@@ -35,7 +60,7 @@ int insert_implications(const std::string &str)
     {
         assert(func.is_operator(lf::OPR_IMPLICATION));
 
-        std::string name = format("imp_%d", n_imp);
+        std::string name = prefix + format("%d", n_imp);
         kb::kb()->insert_implication(func, name);
         ++n_imp;
     }
@@ -44,7 +69,7 @@ int insert_implications(const std::string &str)
 }
 
 
-int insert_inconsistencies(const std::string &str)
+inline int insert_inconsistencies(const std::string &str)
 {
     int n_inc(0);
     std::list<lf::logical_function_t> funcs;
@@ -62,7 +87,7 @@ int insert_inconsistencies(const std::string &str)
 }
 
 
-int insert_unification_postponements(const std::string &str)
+inline int insert_unification_postponements(const std::string &str)
 {
     int n_uni(0);
     std::list<lf::logical_function_t> funcs;
@@ -80,7 +105,215 @@ int insert_unification_postponements(const std::string &str)
 }
 
 
-lf::input_t make_input(const std::string &name, const std::string &input_str)
+/**
+ * Reads top-level s-expressions from a stream and calls `proc` for each of them.
+ * The stream is read in chunks and only one top-level s-expression is held
+ * in memory at a time, so that it can process inputs larger than memory.
+ * Returns the number of s-expressions read.
+ */
+inline int scan_stream(
+    std::istream &in, const std::function<void(const std::string&)> &proc)
+{
+    const size_t CHUNK_SIZE = 1 << 20;
+    std::vector<char> buf(CHUNK_SIZE);
+    std::string expr;
+    int depth(0), n_expr(0);
+    bool in_quote(false), in_comment(false);
+
+    while (in.read(&buf[0], CHUNK_SIZE) or in.gcount() > 0)
+    {
+        for (std::streamsize i = 0; i < in.gcount(); ++i)
+        {
+            char c = buf[i];
+
+            if (in_comment)
+            {
+                if (c == '\n') in_comment = false;
+                continue;
+            }
+
+            if (c == ';' and not in_quote)
+            {
+                in_comment = true;
+                continue;
+            }
+
+            if (depth > 0 or c == '(')
+                expr += c;
+
+            if (c == '"')
+                in_quote = not in_quote;
+            else if (in_quote)
+                continue;
+            else if (c == '(')
+                ++depth;
+            else if (c == ')' and depth > 0 and --depth == 0)
+            {
+                proc(expr);
+                ++n_expr;
+                expr.clear();
+            }
+        }
+    }
+
+    return n_expr;
+}
+
+
+/**
+ * Reads logical functions from a stream and calls `proc` for each of them.
+ * As scan_stream, only one top-level s-expression is held in memory at a time.
+ */
+inline int parse_stream(
+    std::istream &in,
+    const std::function<void(const lf::logical_function_t&)> &proc)
+{
+    std::list<lf::logical_function_t> funcs;
+    int n_func(0);
+
+    scan_stream(in, [&](const std::string &expr)
+    {
+        lf::parse(expr, &funcs);
+        for (const auto &func : funcs)
+        {
+            proc(func);
+            ++n_func;
+        }
+        funcs.clear();
+    });
+
+    return n_func;
+}
+
+
+/**
+ * Inserts every axiom in a stream into the KB through parse_stream.
+ * Functions other than implications, inconsistencies and unification-postponements
+ * are ignored.
+ * Implications are named `prefix` followed by their index in the stream.
+ * Returns the number of axioms inserted.
+ */
+inline int insert_axioms_from_stream(
+    std::istream &in, const std::string &prefix = "imp_")
+{
+    int n_imp(0), n_axiom(0);
+
+    parse_stream(in, [&](const lf::logical_function_t &func)
+    {
+        if (func.is_operator(lf::OPR_IMPLICATION))
+            kb::kb()->insert_implication(
+                func, prefix + format("%d", n_imp++));
+        else if (func.is_operator(lf::OPR_INCONSISTENT))
+            kb::kb()->insert_inconsistency(func);
+        else if (func.is_operator(lf::OPR_UNIPP))
+            kb::kb()->insert_unification_postponement(func);
+        else
+            return;
+
+        ++n_axiom;
+    });
+
+    return n_axiom;
+}
+
+
+/**
+ * Sets up a KB compiled from given axioms in read-only mode.
+ * Each distinct configuration is compiled only at the first call in the process
+ * and reused by later calls, so tests which do not modify the KB can share it.
+ * The caller must call prepare_query() on the KB.
+ */
+inline void setup_shared_kb(
+    const std::string &key_dist,
+    const std::string &key_table,
+    float max_dist,
+    const std::string &implications,
+    const std::string &inconsistencies = "",
+    const std::string &unipps = "")
+{
+    // Paths of compiled KBs, keyed by their whole configurations.
+    static std::map<std::string, std::string> compiled;
+
+    std::string key =
+        format("%s|%s|%f|", key_dist.c_str(), key_table.c_str(), max_dist)
+        + implications + "|" + inconsistencies + "|" + unipps;
+    auto found = compiled.find(key);
+
+    if (found == compiled.end())
+    {
+        // Paths are numbered, so that KBs of different configurations never share one.
+        std::string path = get_kb_dir() + format(
+            "/shared_%d", static_cast<int>(compiled.size()));
+
+        setup_kb(path, key_dist, key_table, max_dist);
+        insert_implications(implications);
+        insert_inconsistencies(inconsistencies);
+        insert_unification_postponements(unipps);
+        kb::kb()->finalize();
+        compiled[key] = path;
+    }
+    else
+    {
+        const std::string &path = found->second;
+        phillip_main_t::set_verbose(NOT_VERBOSE);
+        kb::knowledge_base_t::setup(path, max_dist, 1, false);
+        kb::kb()->set_distance_provider(key_dist);
+        kb::kb()->set_category_table(key_table);
+    }
+}
+
+
+/**
+ * Returns keys of ILP solvers to test.
+ * They are the solvers enabled at compile time,
+ * or the comma-separated keys in PHTEST_SOLVERS if it is set.
+ */
+inline std::vector<std::string> get_solver_keys()
+{
+    std::vector<std::string> keys;
+    const char *env = std::getenv("PHTEST_SOLVERS");
+
+    if (env != NULL)
+    {
+        std::istringstream ss(env);
+        for (std::string key; std::getline(ss, key, ',');)
+            if (not key.empty())
+                keys.push_back(key);
+        return keys;
+    }
+
+#ifdef USE_LP_SOLVE
+    keys.push_back("lpsolve");
+#endif
+#ifdef USE_GUROBI
+    keys.push_back("gurobi");
+#endif
+
+    return keys;
+}
+
+
+/** Sets components of Phillip and prepares the KB for queries. */
+inline void setup_phillip(
+    phillip_main_t *phillip,
+    const std::string &key_lhs,
+    const std::string &key_ilp,
+    const std::string &key_sol)
+{
+    phillip->set_lhs_enumerator(
+        bin::lhs_enumerator_library_t::instance()
+        ->generate(key_lhs, phillip));
+    phillip->set_ilp_convertor(
+        bin::ilp_converter_library_t::instance()
+        ->generate(key_ilp, phillip));
+    phillip->set_ilp_solver(
+        bin::ilp_solver_library_t::instance()
+        ->generate(key_sol, phillip));
+    kb::kb()->prepare_query();
+}
+
+
+inline lf::input_t make_input(const std::string &name, const std::string &input_str)
 {
     std::list<lf::logical_function_t> input_lf;
     lf::parse(input_str, &input_lf);
@@ -100,5 +333,71 @@ lf::input_t make_input(const std::string &name, const std::string &input_str)
 }
 
 
+/**
+ * Reads observations in the input format of Phillip, such as
+ * `(O (name doc1) (^ (p x) (q y)))`, and calls `proc` for each of them.
+ * Each lf::input_t is built only when its turn comes, so that
+ * a stream of any number of documents can be replayed.
+ * Observations without names are named "doc" followed by their index.
+ * Returns the number of observations read.
+ */
+inline int parse_input_stream(
+    std::istream &in, const std::function<void(const lf::input_t&)> &proc)
+{
+    int n_input(0);
+
+    scan_stream(in, [&](const std::string &expr)
+    {
+        std::string name = format("doc%d", n_input), body;
+        int depth(0);
+        size_t begin(0);
+
+        // SPLITS THE EXPRESSION INTO ITS CHILDREN
+        for (size_t i = 0; i < expr.size(); ++i)
+        {
+            if (expr[i] == '(' and depth++ == 1)
+                begin = i;
+            else if (expr[i] == ')' and --depth == 1)
+            {
+                std::string child = expr.substr(begin, i - begin + 1);
+                if (child.compare(0, 6, "(name ") == 0)
+                    name = child.substr(6, child.size() - 7);
+                else
+                    body += child;
+            }
+        }
+
+        bool is_obs =
+            expr.size() > 2 and expr[1] == 'O' and
+            std::isspace(static_cast<unsigned char>(expr[2]));
+        if (not is_obs)
+            body = expr;
+
+        proc(make_input(name, body));
+        ++n_input;
+    });
+
+    return n_input;
+}
+
+
+/** Returns the p-th percentile (0 <= p <= 100) of values, which get sorted. */
+inline double get_percentile(std::vector<double> *values, double p)
+{
+    if (values->empty()) return 0.0;
+
+    std::sort(values->begin(), values->end());
+    size_t i = static_cast<size_t>(p / 100.0 * (values->size() - 1) + 0.5);
+    return (*values)[std::min(i, values->size() - 1)];
+}
+
+
+/** Returns the number of axioms for scale tests, given by PHTEST_SCALE. */
+inline int get_test_scale()
+{
+    const char *env = std::getenv("PHTEST_SCALE");
+    return (env != NULL) ? std::atoi(env) : 1000;
+}
+
 
 }